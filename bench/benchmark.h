@@ -0,0 +1,162 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace bench {
+
+    // Prevents the compiler from optimizing away the computation of the value.
+    template<typename T>
+    inline void DoNotOptimize(const T &value) {
+#if defined(__GNUC__) || defined(__clang__)
+        asm volatile("" : : "r,m"(value) : "memory");
+#else
+        static volatile const void *sink;
+        sink = &value;
+#endif
+    }
+
+    // Number of samples the time of a call is averaged over.
+    constexpr size_t kSamplesCount = 10;
+
+    struct Measurement {
+        uint64_t calls_per_sample;
+
+        // Seconds per call of every sample.
+        std::vector<double> samples;
+
+    public:
+        double Mean() const {
+            double total = 0;
+            for (double sample : samples)
+                total += sample;
+
+            return total / static_cast<double>(samples.size());
+        }
+
+        double StandardDeviation() const {
+            const double mean = Mean();
+
+            double total = 0;
+            for (double sample : samples)
+                total += (sample - mean) * (sample - mean);
+
+            return samples.size() > 1 ? std::sqrt(total / static_cast<double>(samples.size() - 1)) : 0;
+        }
+
+        double Min() const {
+            return *std::min_element(samples.begin(), samples.end());
+        }
+    };
+
+    /**
+     * Runs the function for about the given time, split into samples of the same number of calls.
+     * The number of calls is calibrated first, which also warms up the caches.
+     */
+    template<typename Function>
+    Measurement Measure(Function function, double min_seconds) {
+        using Clock = std::chrono::steady_clock;
+
+        const auto time = [&](uint64_t calls) {
+            const Clock::time_point start = Clock::now();
+            for (uint64_t call = 0; call < calls; call++)
+                function();
+
+            return std::chrono::duration<double>(Clock::now() - start).count();
+        };
+
+        const double sample_seconds = min_seconds / static_cast<double>(kSamplesCount);
+
+        uint64_t calls = 1;
+        double seconds = time(calls);
+
+        while (seconds < sample_seconds / 10) {
+            calls *= 10;
+            seconds = time(calls);
+        }
+
+        Measurement measurement;
+        measurement.calls_per_sample = std::max<uint64_t>(
+                1, static_cast<uint64_t>(static_cast<double>(calls) * sample_seconds / seconds));
+
+        for (size_t sample = 0; sample < kSamplesCount; sample++) {
+            const double sample_time = time(measurement.calls_per_sample);
+            measurement.samples.push_back(sample_time / static_cast<double>(measurement.calls_per_sample));
+        }
+
+        return measurement;
+    }
+
+    struct Result {
+        std::string name;
+
+        // What a call processes: "item" or "byte".
+        const char *unit;
+        uint64_t units_per_call;
+
+        uint64_t samples;
+        double mean_ns_per_call;
+        double min_ns_per_call;
+        double stddev_ns_per_call;
+    };
+
+    // Results of all the benchmarks run so far.
+    inline std::vector<Result> &AccessResults() {
+        static std::vector<Result> results;
+        return results;
+    }
+
+    inline const Result &AddResult(const char *name, const char *unit, uint64_t units_per_call,
+                                   const Measurement &measurement) {
+        AccessResults().push_back(Result{
+                name,
+                unit,
+                units_per_call,
+                measurement.samples.size(),
+                measurement.Mean() * 1e9,
+                measurement.Min() * 1e9,
+                measurement.StandardDeviation() * 1e9
+        });
+
+        return AccessResults().back();
+    }
+
+    // Standard deviation relative to the mean, in percents.
+    inline double RelativeDeviation(const Result &result) {
+        return result.mean_ns_per_call > 0 ? result.stddev_ns_per_call / result.mean_ns_per_call * 100 : 0;
+    }
+
+    /**
+     * Runs the function repeatedly for about the given time and prints the time per item.
+     *
+     * @param items Number of items processed by a single call of the function.
+     */
+    template<typename Function>
+    void Run(const char *name, uint64_t items, Function function, double min_seconds = 0.5) {
+        const Result &result = AddResult(name, "item", items, Measure(function, min_seconds));
+        const double ns_per_item = result.mean_ns_per_call / static_cast<double>(items);
+
+        std::printf("%-40s %12.2f ns/item %6.1f%% sd %14.0f items/s\n",
+                    name, ns_per_item, RelativeDeviation(result), 1e9 / ns_per_item);
+    }
+
+    /**
+     * Runs the function repeatedly for about the given time and prints the throughput.
+     *
+     * @param bytes Number of bytes processed by a single call of the function.
+     */
+    template<typename Function>
+    void RunBytes(const char *name, uint64_t bytes, Function function, double min_seconds = 0.5) {
+        const Result &result = AddResult(name, "byte", bytes, Measure(function, min_seconds));
+
+        std::printf("%-40s %12.2f ms/call %6.1f%% sd %14.2f MB/s\n",
+                    name, result.mean_ns_per_call / 1e6, RelativeDeviation(result),
+                    static_cast<double>(bytes) / result.mean_ns_per_call * 1e3);
+    }
+
+}
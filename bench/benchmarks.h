@@ -0,0 +1,13 @@
+#pragma once
+
+void RunClippingBenchmarks();
+
+void RunDrawBenchmarks();
+
+void RunMathBenchmarks();
+
+void RunMeshBenchmarks();
+
+void RunObjParserBenchmarks();
+
+void RunWorldBenchmarks();
@@ -0,0 +1,128 @@
+#include <array>
+#include <list>
+#include <random>
+#include <vector>
+
+#include "engine/math/angle.h"
+#include "engine/math/clip_polygon.h"
+#include "engine/math/frustum.h"
+#include "engine/math/graphics_utils.h"
+
+#include "benchmark.h"
+#include "benchmarks.h"
+
+using Triangle = std::array<Vector3, 3>;
+
+// Triangle clipper that was used by Engine::Draw before ClipPolygon. Kept as the reference.
+static void LegacyClipTriangles(const Frustum &frustum, std::list<Triangle> &triangles) {
+    for (const Plane &clipping_plane : frustum.GetPlanes()) {
+        for (auto it = triangles.begin(); it != triangles.end();) {
+            Triangle &triangle_points = *it;
+
+            Vector3 inside_points[3];
+            uint32_t inside_points_count = 0;
+            Vector3 outside_points[3];
+            uint32_t outside_points_count = 0;
+
+            for (const Vector3 &point : triangle_points) {
+                if (clipping_plane.IsOutside(point))
+                    outside_points[outside_points_count++] = point;
+                else
+                    inside_points[inside_points_count++] = point;
+            }
+
+            if (inside_points_count == 0) {
+                it = triangles.erase(it);
+                continue;
+            }
+
+            if (outside_points_count == 0) {
+                ++it;
+                continue;
+            }
+
+            if (inside_points_count == 1) {
+                Plane::Intersection intersection1 = clipping_plane.IntersectLine(inside_points[0], outside_points[0]);
+                Plane::Intersection intersection2 = clipping_plane.IntersectLine(inside_points[0], outside_points[1]);
+
+                triangle_points = {inside_points[0], intersection1.Point(), intersection2.Point()};
+            } else {
+                Plane::Intersection intersection1 = clipping_plane.IntersectLine(inside_points[0], outside_points[0]);
+                Plane::Intersection intersection2 = clipping_plane.IntersectLine(inside_points[1], outside_points[0]);
+
+                triangle_points = {inside_points[0], intersection1.Point(), inside_points[1]};
+                triangles.emplace(it, Triangle{intersection1.Point(), intersection2.Point(), inside_points[1]});
+            }
+            ++it;
+        }
+    }
+}
+
+static Frustum CreateBenchmarkFrustum() {
+    const Matrix4 view = CreateViewMatrix(Vector3::Zero(), Vector3(1, 0, 0), Vector3(0, 1, 0), Vector3(0, 0, 1));
+    const Matrix4 projection = CreateProjectionMatrix(16.f / 9.f, Radians(60), 0.1f, 100.f);
+
+    Frustum frustum;
+    frustum.SetFromModelViewProjection(projection * view);
+    frustum.Invert();
+
+    return frustum;
+}
+
+// Triangles scattered around the frustum, so that some are inside, some outside and some cross its planes.
+static std::vector<Triangle> GenerateTriangles(size_t count) {
+    std::mt19937 random(42);
+    std::uniform_real_distribution<float> center_x(-40.f, 40.f);
+    std::uniform_real_distribution<float> center_y(-25.f, 25.f);
+    std::uniform_real_distribution<float> center_z(-5.f, 110.f);
+    std::uniform_real_distribution<float> offset(-3.f, 3.f);
+
+    std::vector<Triangle> triangles(count);
+
+    for (Triangle &triangle : triangles) {
+        const Vector3 center(center_x(random), center_y(random), center_z(random));
+
+        for (Vector3 &point : triangle)
+            point = center + Vector3(offset(random), offset(random), offset(random));
+    }
+
+    return triangles;
+}
+
+void RunClippingBenchmarks() {
+    const Frustum frustum = CreateBenchmarkFrustum();
+    const std::vector<Triangle> triangles = GenerateTriangles(100000);
+
+    bench::Run("clip_triangles/legacy_list", triangles.size(), [&]() {
+        size_t output_triangles = 0;
+
+        for (const Triangle &triangle : triangles) {
+            std::list<Triangle> clipped;
+            clipped.emplace_back(triangle);
+
+            LegacyClipTriangles(frustum, clipped);
+            output_triangles += clipped.size();
+        }
+
+        bench::DoNotOptimize(output_triangles);
+    });
+
+    bench::Run("clip_triangles/clip_polygon", triangles.size(), [&]() {
+        size_t output_triangles = 0;
+
+        for (const Triangle &triangle : triangles) {
+            ClipPolygon<Vector3> polygon(triangle[0], triangle[1], triangle[2]);
+
+            for (const Plane &clipping_plane : frustum.GetPlanes()) {
+                polygon.Clip([&](const Vector3 &point) { return clipping_plane.DistanceTo(point); });
+
+                if (polygon.IsEmpty())
+                    break;
+            }
+
+            output_triangles += polygon.GetTrianglesCount();
+        }
+
+        bench::DoNotOptimize(output_triangles);
+    });
+}
@@ -0,0 +1,51 @@
+#include <cstdio>
+#include <memory>
+#include <string>
+
+#include "engine/engine.h"
+#include "engine/render/null_renderer.h"
+
+#include "scenes.h"
+
+#include "benchmark.h"
+#include "benchmarks.h"
+
+/**
+ * Draws the scene with the engine through a null renderer, so only the work of Engine::Draw is measured.
+ * The frames are processed on a single thread, to measure the cost per core regardless of the machine.
+ * The time is reported per face of the objects in the frustum.
+ */
+static void RunScene(const scenes::Scene &scene) {
+    std::shared_ptr<render::Renderer> renderer = std::make_shared<render::NullRenderer>();
+
+    Engine engine;
+    engine.SetJobSystem(std::make_shared<jobs::JobSystem>(1));
+    engine.Initialize(ViewPort(1280, 720), renderer);
+    engine.AccessSettings()->cull_mode = scene.cull_mode;
+
+    scene.populate(engine.GetWorld().get());
+
+    engine.Draw();
+    const PipelineStatistics statistics = engine.GetPipelineStatistics();
+
+    const uint64_t objects_drawn = statistics.objects_visited - statistics.objects_culled - statistics.objects_skipped;
+
+    const std::string name = std::string("draw/") + scene.name;
+
+    std::printf("%s: %llu objects drawn, %llu faces, %llu culled, %llu clipped, %llu triangles submitted\n",
+                name.c_str(), static_cast<unsigned long long>(objects_drawn),
+                static_cast<unsigned long long>(statistics.faces_in),
+                static_cast<unsigned long long>(statistics.faces_culled),
+                static_cast<unsigned long long>(statistics.faces_clipped),
+                static_cast<unsigned long long>(statistics.triangles_submitted));
+
+    bench::Run(name.c_str(), std::max<uint64_t>(statistics.faces_in, 1), [&]() {
+        engine.Draw();
+    }, 1.0);
+}
+
+void RunDrawBenchmarks() {
+    // The objects don't spin, every frame is the same.
+    for (const scenes::Scene &scene : scenes::CreateScenes(false))
+        RunScene(scene);
+}
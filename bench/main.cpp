@@ -0,0 +1,107 @@
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "benchmark.h"
+#include "benchmarks.h"
+
+struct Suite {
+    const char *name;
+    void (*run)();
+};
+
+// Writes the results as {"benchmarks": [...]}, the times per call in nanoseconds.
+static bool WriteJson(const std::string &path, const std::vector<bench::Result> &results) {
+    FILE *file = std::fopen(path.c_str(), "w");
+    if (!file)
+        return false;
+
+    std::fprintf(file, "{\n  \"benchmarks\": [");
+
+    for (size_t i = 0; i < results.size(); i++) {
+        const bench::Result &result = results[i];
+        const double ns_per_unit = result.mean_ns_per_call / static_cast<double>(result.units_per_call);
+
+        std::fprintf(file, "%s\n    {\"name\": \"", i == 0 ? "" : ",");
+
+        for (const char c : result.name) {
+            if (c == '"' || c == '\\')
+                std::fputc('\\', file);
+            std::fputc(c, file);
+        }
+
+        std::fprintf(file, "\", \"unit\": \"%s\", \"units_per_call\": %llu, \"samples\": %llu, "
+                           "\"mean_ns_per_call\": %.3f, \"min_ns_per_call\": %.3f, \"stddev_ns_per_call\": %.3f, "
+                           "\"ns_per_unit\": %.6f, \"units_per_second\": %.1f}",
+                     result.unit, static_cast<unsigned long long>(result.units_per_call),
+                     static_cast<unsigned long long>(result.samples), result.mean_ns_per_call,
+                     result.min_ns_per_call, result.stddev_ns_per_call, ns_per_unit, 1e9 / ns_per_unit);
+    }
+
+    std::fprintf(file, "\n  ]\n}\n");
+
+    const bool success = std::ferror(file) == 0;
+    std::fclose(file);
+
+    return success;
+}
+
+// Usage: engine_bench [suite...] [--json <file>]. Without suites all the suites are run.
+int main(int argc, char **argv) {
+    const Suite suites[] = {
+            {"clipping",   RunClippingBenchmarks},
+            {"draw",       RunDrawBenchmarks},
+            {"math",       RunMathBenchmarks},
+            {"mesh",       RunMeshBenchmarks},
+            {"obj_parser", RunObjParserBenchmarks},
+            {"world",      RunWorldBenchmarks},
+    };
+
+    std::vector<const char *> selected_suites;
+    std::string json_path;
+
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--json") == 0) {
+            if (i + 1 == argc) {
+                std::printf("Usage: %s [suite...] [--json <file>]\n", argv[0]);
+                return 1;
+            }
+
+            json_path = argv[++i];
+            continue;
+        }
+
+        bool found = false;
+
+        for (const Suite &suite : suites)
+            found |= std::strcmp(argv[i], suite.name) == 0;
+
+        if (!found) {
+            std::printf("Unknown suite %s. Suites:", argv[i]);
+            for (const Suite &suite : suites)
+                std::printf(" %s", suite.name);
+            std::printf("\n");
+            return 1;
+        }
+
+        selected_suites.push_back(argv[i]);
+    }
+
+    for (const Suite &suite : suites) {
+        bool selected = selected_suites.empty();
+
+        for (const char *name : selected_suites)
+            selected |= std::strcmp(name, suite.name) == 0;
+
+        if (selected)
+            suite.run();
+    }
+
+    if (!json_path.empty() && !WriteJson(json_path, bench::AccessResults())) {
+        std::printf("Unable to write %s.\n", json_path.c_str());
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,177 @@
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "engine/mesh.h"
+#include "engine/math/frustum.h"
+#include "engine/math/plane.h"
+#include "engine/math/simd/simd.h"
+
+#include "benchmark.h"
+#include "benchmarks.h"
+
+static Matrix4 RandomMatrix(std::mt19937 &random) {
+    std::uniform_real_distribution<float> value(-2.f, 2.f);
+
+    Matrix4 matrix;
+    for (size_t row = 0; row < 4; row++)
+        for (size_t col = 0; col < 4; col++)
+            matrix[row][col] = value(random);
+
+    return matrix;
+}
+
+static float MaxDifference(const std::vector<Vector4> &lhs, const std::vector<Vector4> &rhs) {
+    float max_difference = 0;
+
+    for (size_t i = 0; i < lhs.size(); i++)
+        for (size_t j = 0; j < 4; j++)
+            max_difference = std::max(max_difference, std::abs(lhs[i][j] - rhs[i][j]));
+
+    return max_difference;
+}
+
+static Vector3 RandomVector(std::mt19937 &random) {
+    std::uniform_real_distribution<float> coordinate(-10.f, 10.f);
+
+    return Vector3(coordinate(random), coordinate(random), coordinate(random));
+}
+
+// The math types used one by one in the engine, on arrays of random inputs so that nothing is constant folded.
+static void RunScalarBenchmarks(std::mt19937 &random) {
+    constexpr size_t kCount = 1024;
+
+    std::vector<Matrix4> matrices(kCount);
+    std::vector<Vector3> points(kCount);
+    std::vector<Vector3> other_points(kCount);
+    std::vector<Plane> planes(kCount);
+
+    for (size_t i = 0; i < kCount; i++) {
+        matrices[i] = RandomMatrix(random);
+        points[i] = RandomVector(random);
+        other_points[i] = RandomVector(random);
+        planes[i] = Plane(RandomVector(random).GetNormalized(), RandomVector(random));
+    }
+
+    std::vector<Matrix4> matrix_results(kCount);
+    std::vector<Vector3> vector_results(kCount);
+
+    bench::Run("math/matrix4_multiply", kCount, [&]() {
+        for (size_t i = 0; i < kCount; i++)
+            matrix_results[i] = matrices[i] * matrices[(i + 1) % kCount];
+        bench::DoNotOptimize(matrix_results[0]);
+    });
+
+    bench::Run("math/matrix4_transform_point", kCount, [&]() {
+        for (size_t i = 0; i < kCount; i++)
+            vector_results[i] = matrices[i] * points[i];
+        bench::DoNotOptimize(vector_results[0]);
+    });
+
+    bench::Run("math/vector3_normalize", kCount, [&]() {
+        for (size_t i = 0; i < kCount; i++)
+            vector_results[i] = points[i].GetNormalized();
+        bench::DoNotOptimize(vector_results[0]);
+    });
+
+    bench::Run("math/vector3_cross", kCount, [&]() {
+        for (size_t i = 0; i < kCount; i++)
+            vector_results[i] = points[i].Cross(other_points[i]);
+        bench::DoNotOptimize(vector_results[0]);
+    });
+
+    bench::Run("math/plane_intersect_line", kCount, [&]() {
+        size_t intersections = 0;
+        for (size_t i = 0; i < kCount; i++)
+            intersections += planes[i].IntersectLine(points[i], other_points[i]).Exists();
+        bench::DoNotOptimize(intersections);
+    });
+
+    bench::Run("math/frustum_from_model_view_projection", kCount, [&]() {
+        Frustum frustum;
+        for (size_t i = 0; i < kCount; i++) {
+            frustum.SetFromModelViewProjection(matrices[i]);
+            bench::DoNotOptimize(frustum);
+        }
+    });
+}
+
+void RunMathBenchmarks() {
+    std::mt19937 random(7);
+    std::uniform_real_distribution<float> coordinate(-10.f, 10.f);
+
+    const Matrix4 lhs = RandomMatrix(random);
+    const Matrix4 rhs = RandomMatrix(random);
+    const Vector4 vector(coordinate(random), coordinate(random), coordinate(random), 1.f);
+
+    // Mesh vertices, so the points are strided like in Engine::Draw.
+    std::vector<Mesh::Vertex> vertices(100000);
+    for (Mesh::Vertex &vertex : vertices) {
+        vertex.position = Vector3(coordinate(random), coordinate(random), coordinate(random));
+        vertex.color = Color::White();
+    }
+
+    Mesh mesh;
+    mesh.SetVertices(std::vector<Mesh::Vertex>(vertices));
+    mesh.SetVertexLayout(Mesh::VertexLayout::kStructureOfArrays);
+
+    const Mesh::VertexStreams &streams = mesh.GetVertexStreams();
+
+    std::vector<Vector4> reference(vertices.size());
+    simd::GetScalarKernels()->transform_points(lhs, &vertices[0].position, sizeof(Mesh::Vertex),
+                                               reference.data(), reference.size());
+
+    RunScalarBenchmarks(random);
+
+    std::printf("Selected kernels: %s\n", simd::GetKernels().name);
+
+    for (simd::InstructionSet instruction_set : {simd::InstructionSet::kScalar,
+                                                 simd::InstructionSet::kSSE,
+                                                 simd::InstructionSet::kAVX2}) {
+        if (!simd::IsInstructionSetSupported(instruction_set))
+            continue;
+
+        const simd::Kernels &kernels = *simd::GetKernels(instruction_set);
+        const std::string prefix = std::string("simd/") + kernels.name;
+
+        constexpr size_t kRepetitions = 1000;
+
+        bench::Run((prefix + "/multiply_matrices").c_str(), kRepetitions, [&]() {
+            Matrix4 result = lhs;
+            for (size_t i = 0; i < kRepetitions; i++)
+                kernels.multiply_matrices(rhs, result, &result);
+            bench::DoNotOptimize(result);
+        });
+
+        bench::Run((prefix + "/transform_vector").c_str(), kRepetitions, [&]() {
+            Vector4 result = vector;
+            for (size_t i = 0; i < kRepetitions; i++)
+                kernels.transform_vector(lhs, result, &result);
+            bench::DoNotOptimize(result);
+        });
+
+        std::vector<Vector4> transformed(vertices.size());
+
+        bench::Run((prefix + "/transform_points").c_str(), vertices.size(), [&]() {
+            kernels.transform_points(lhs, &vertices[0].position, sizeof(Mesh::Vertex),
+                                     transformed.data(), transformed.size());
+            bench::DoNotOptimize(transformed[0]);
+        });
+
+        float max_difference = MaxDifference(reference, transformed);
+        if (max_difference > 1e-3f)
+            std::printf("  WARNING: %s/transform_points differs from scalar by %f\n", kernels.name, max_difference);
+
+        bench::Run((prefix + "/transform_points_soa").c_str(), vertices.size(), [&]() {
+            kernels.transform_points_soa(lhs, streams.x.data(), streams.y.data(), streams.z.data(),
+                                         transformed.data(), transformed.size());
+            bench::DoNotOptimize(transformed[0]);
+        });
+
+        max_difference = MaxDifference(reference, transformed);
+        if (max_difference > 1e-3f)
+            std::printf("  WARNING: %s/transform_points_soa differs from scalar by %f\n", kernels.name, max_difference);
+    }
+}
@@ -0,0 +1,138 @@
+#include <cmath>
+#include <cstdio>
+#include <memory>
+#include <string>
+
+#include "engine/mesh.h"
+#include "engine/obj_parser.h"
+
+#include "benchmark.h"
+#include "benchmarks.h"
+
+// .obj text of a wavy grid of size x size vertices, two triangles per cell, formatted like exported scans.
+// With face_attributes the faces also reference texture coordinates and normals: v/vt/vn.
+static std::string GenerateGridObj(uint32_t size, bool face_attributes = false) {
+    std::string text;
+    char line[96];
+
+    text += "# Synthetic grid\n";
+
+    for (uint32_t y = 0; y < size; y++) {
+        for (uint32_t x = 0; x < size; x++) {
+            const float px = static_cast<float>(x) * 0.01f - 5.f;
+            const float py = static_cast<float>(y) * 0.01f - 5.f;
+
+            std::snprintf(line, sizeof(line), "v %.6f %.6f %.6f\n", px, py, std::sin(px) * std::cos(py));
+            text += line;
+        }
+    }
+
+    const auto append_face = [&](uint32_t i1, uint32_t i2, uint32_t i3) {
+        if (face_attributes)
+            std::snprintf(line, sizeof(line), "f %u/%u/%u %u/%u/%u %u/%u/%u\n", i1, i1, i1, i2, i2, i2, i3, i3, i3);
+        else
+            std::snprintf(line, sizeof(line), "f %u %u %u\n", i1, i2, i3);
+
+        text += line;
+    };
+
+    for (uint32_t y = 0; y + 1 < size; y++) {
+        for (uint32_t x = 0; x + 1 < size; x++) {
+            const uint32_t i = y * size + x + 1;
+
+            append_face(i, i + 1, i + size);
+            append_face(i + 1, i + size + 1, i + size);
+        }
+    }
+
+    return text;
+}
+
+static void RunGridBenchmarks(const char *name, uint32_t size) {
+    const std::string text = GenerateGridObj(size);
+
+    const std::shared_ptr<Mesh> mesh = ObjParser::Parse(text);
+    if (!mesh) {
+        std::printf("  WARNING: failed to parse the %s grid\n", name);
+        return;
+    }
+
+    const std::string prefix = std::string("mesh/") + name;
+
+    bench::Run((prefix + "/parse_faces").c_str(), mesh->GetFacesCount(), [&]() {
+        bench::DoNotOptimize(ObjParser::Parse(text));
+    }, 1.0);
+
+    const memory::ArrayView<Mesh::Vertex> vertices = mesh->GetVertices();
+
+    // The access pattern of the face loop of Engine::Draw.
+    bench::Run((prefix + "/visit_faces").c_str(), mesh->GetFacesCount(), [&]() {
+        float sum = 0;
+
+        mesh->GetIndices().Visit([&](const auto *indices, size_t faces_count) {
+            for (size_t face = 0; face < faces_count; face++, indices += 3)
+                sum += vertices[indices[0]].position[0] + vertices[indices[1]].position[1] +
+                       vertices[indices[2]].position[2];
+        });
+
+        bench::DoNotOptimize(sum);
+    });
+
+    // Face normals recomputed from the positions, as every frame did before they were stored in the mesh.
+    bench::Run((prefix + "/face_normals_computed").c_str(), mesh->GetFacesCount(), [&]() {
+        float sum = 0;
+
+        mesh->GetIndices().Visit([&](const auto *indices, size_t faces_count) {
+            for (size_t face = 0; face < faces_count; face++, indices += 3) {
+                const Vector3 &p1 = vertices[indices[0]].position;
+                const Vector3 &p2 = vertices[indices[1]].position;
+                const Vector3 &p3 = vertices[indices[2]].position;
+
+                Vector3 normal = (p2 - p1).Cross(p3 - p1);
+                normal.Normalize();
+
+                sum += normal[2];
+            }
+        });
+
+        bench::DoNotOptimize(sum);
+    });
+
+    const memory::ArrayView<Mesh::FacePlane> face_planes = mesh->GetFacePlanes();
+
+    bench::Run((prefix + "/face_normals_stored").c_str(), mesh->GetFacesCount(), [&]() {
+        float sum = 0;
+
+        for (const Mesh::FacePlane &plane : face_planes)
+            sum += plane.normal[2];
+
+        bench::DoNotOptimize(sum);
+    });
+}
+
+static void RunParserBenchmark(const char *name, uint32_t size, bool face_attributes) {
+    const std::string text = GenerateGridObj(size, face_attributes);
+    const std::string prefix = std::string("obj_parser/") + name;
+
+    bench::RunBytes((prefix + "/serial").c_str(), text.size(), [&]() {
+        bench::DoNotOptimize(ObjParser::Parse(text));
+    }, 2.0);
+
+    jobs::JobSystem job_system;
+
+    bench::RunBytes((prefix + "/parallel_" + std::to_string(job_system.GetThreadsCount())).c_str(), text.size(),
+                    [&]() {
+        bench::DoNotOptimize(ObjParser::Parse(text, &job_system));
+    }, 2.0);
+}
+
+void RunObjParserBenchmarks() {
+    RunParserBenchmark("grid_1024", 1024, false);
+    RunParserBenchmark("grid_1024_attributes", 1024, true);
+}
+
+void RunMeshBenchmarks() {
+    // 16-bit and 32-bit indices.
+    RunGridBenchmarks("grid_128", 128);
+    RunGridBenchmarks("grid_724", 724);
+}
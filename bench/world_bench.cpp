@@ -0,0 +1,107 @@
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "engine/world.h"
+#include "engine/math/angle.h"
+#include "engine/math/graphics_utils.h"
+
+#include "benchmark.h"
+#include "benchmarks.h"
+
+static std::shared_ptr<Mesh> CreateTetrahedron() {
+    auto mesh = std::make_shared<Mesh>();
+
+    mesh->SetVertices({{Vector3(1, 1, 1), Color::Black()}, {Vector3(1, -1, -1), Color::Black()},
+                       {Vector3(-1, 1, -1), Color::Black()}, {Vector3(-1, -1, 1), Color::Black()}});
+    mesh->SetIndices(IndexBuffer({0, 1, 2, 0, 3, 1, 0, 2, 3, 1, 3, 2}, 4));
+
+    return mesh;
+}
+
+// Objects scattered in a large cube, so that a small part of them is in front of the camera.
+static void PopulateWorld(World *world, size_t count) {
+    std::mt19937 random(42);
+    std::uniform_real_distribution<float> position(-1000.f, 1000.f);
+    std::uniform_real_distribution<float> angle(0, Radians(360));
+
+    const std::shared_ptr<Mesh> mesh = CreateTetrahedron();
+
+    for (size_t i = 0; i < count; i++) {
+        World::ObjectDescription description;
+        description.mesh = mesh;
+        description.position = Vector3(position(random), position(random), position(random));
+        description.rotation_angles = Vector2(angle(random), angle(random));
+        description.rotation_velocity = Vector2(Radians(90), Radians(45));
+
+        world->AddObject(description);
+    }
+
+    world->UpdateBounds();
+}
+
+void RunWorldBenchmarks() {
+    constexpr size_t kObjectsCount = 100000;
+
+    World world;
+    PopulateWorld(&world, kObjectsCount);
+
+    const Matrix4 view = CreateViewMatrix(Vector3::Zero(), Vector3(1, 0, 0), Vector3(0, 1, 0), Vector3(0, 0, 1));
+    const Matrix4 projection = CreateProjectionMatrix(16.f / 9.f, Radians(60), 0.1f, 500.f);
+
+    Frustum frustum;
+    frustum.SetFromModelViewProjection(projection * view);
+
+    // What Engine::Draw did for every object before the hierarchy.
+    bench::Run("frustum_query/linear", kObjectsCount, [&]() {
+        size_t visible_objects = 0;
+
+        for (const World::ObjectHandle object : world.ListObjects()) {
+            const BoundingSphere &sphere = world.GetMesh(object)->GetBounds().sphere;
+            const BoundingSphere world_sphere{world.GetModelMatrix(object) * sphere.center, sphere.radius};
+
+            visible_objects += frustum.Contains(world_sphere) != Frustum::Containment::kOutside;
+        }
+
+        bench::DoNotOptimize(visible_objects);
+    });
+
+    std::vector<World::FrustumQueryResult> visible_objects;
+
+    bench::Run("frustum_query/bvh", kObjectsCount, [&]() {
+        world.QueryFrustum(frustum, &visible_objects);
+        bench::DoNotOptimize(visible_objects.size());
+    });
+
+    // The objects don't move, so only their bounds are recomputed.
+    bench::Run("update_bounds/static", kObjectsCount, [&]() {
+        world.UpdateBounds();
+    });
+
+    std::mt19937 random(7);
+    std::uniform_real_distribution<float> direction(-1.f, 1.f);
+
+    constexpr size_t kRaysCount = 1000;
+
+    bench::Run("raycast/bvh", kRaysCount, [&]() {
+        size_t hits = 0;
+
+        for (size_t i = 0; i < kRaysCount; i++) {
+            World::RaycastHit hit;
+            hits += world.Raycast(Vector3::Zero(), Vector3(direction(random), direction(random), direction(random)),
+                                  2000.f, &hit);
+        }
+
+        bench::DoNotOptimize(hits);
+    });
+
+    // A pass over the transforms of many objects, which streams through the component arrays.
+    constexpr size_t kManyObjectsCount = 1000000;
+
+    World many_objects_world;
+    PopulateWorld(&many_objects_world, kManyObjectsCount);
+
+    bench::Run("update_rotations", kManyObjectsCount, [&]() {
+        many_objects_world.UpdateRotations(1.f / 60);
+    });
+}
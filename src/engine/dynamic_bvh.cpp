@@ -0,0 +1,316 @@
+#include <algorithm>
+#include <cassert>
+
+#include "dynamic_bvh.h"
+
+// The insertion and the balancing follow b2DynamicTree of Box2D.
+// https://github.com/erincatto/box2d/blob/main/src/collision/b2_dynamic_tree.cpp
+
+int32_t DynamicBvh::Insert(const BoundingBox &box, uint32_t user_data) {
+    const int32_t leaf = AllocateNode();
+
+    Node &node = nodes_[leaf];
+    node.box = Enlarge(box);
+    node.user_data = user_data;
+    node.height = 0;
+
+    InsertLeaf(leaf);
+    leaves_count_++;
+
+    return leaf;
+}
+
+void DynamicBvh::Remove(int32_t leaf) {
+    assert(leaf >= 0 && static_cast<size_t>(leaf) < nodes_.size() && nodes_[leaf].IsLeaf() &&
+           nodes_[leaf].height == 0 && "Not a leaf");
+
+    RemoveLeaf(leaf);
+    FreeNode(leaf);
+    leaves_count_--;
+}
+
+bool DynamicBvh::Update(int32_t leaf, const BoundingBox &box) {
+    assert(leaf >= 0 && static_cast<size_t>(leaf) < nodes_.size() && nodes_[leaf].IsLeaf() &&
+           nodes_[leaf].height == 0 && "Not a leaf");
+
+    if (!NeedsUpdate(leaf, box))
+        return false;
+
+    RemoveLeaf(leaf);
+    nodes_[leaf].box = Enlarge(box);
+    InsertLeaf(leaf);
+
+    return true;
+}
+
+bool DynamicBvh::NeedsUpdate(int32_t leaf, const BoundingBox &box) const {
+    const BoundingBox &fat_box = nodes_[leaf].box;
+
+    // The leaf is also reinserted when its box shrank a lot, so the fat box doesn't stay too large.
+    return !Contains(fat_box, box) || SurfaceArea(fat_box) > 4 * SurfaceArea(Enlarge(box));
+}
+
+uint32_t DynamicBvh::GetUserData(int32_t leaf) const {
+    return nodes_[leaf].user_data;
+}
+
+const BoundingBox &DynamicBvh::GetFatBox(int32_t leaf) const {
+    return nodes_[leaf].box;
+}
+
+size_t DynamicBvh::GetLeavesCount() const {
+    return leaves_count_;
+}
+
+int32_t DynamicBvh::GetHeight() const {
+    return root_ == kNullNode ? 0 : nodes_[root_].height;
+}
+
+int32_t DynamicBvh::AllocateNode() {
+    int32_t node;
+
+    if (free_list_ != kNullNode) {
+        node = free_list_;
+        free_list_ = nodes_[node].parent;
+    } else {
+        node = static_cast<int32_t>(nodes_.size());
+        nodes_.emplace_back();
+    }
+
+    nodes_[node] = Node{BoundingBox{}, kNullNode, {kNullNode, kNullNode}, 0, 0};
+
+    return node;
+}
+
+void DynamicBvh::FreeNode(int32_t node) {
+    nodes_[node].parent = free_list_;
+    nodes_[node].height = -1;
+    free_list_ = node;
+}
+
+void DynamicBvh::InsertLeaf(int32_t leaf) {
+    if (root_ == kNullNode) {
+        root_ = leaf;
+        nodes_[leaf].parent = kNullNode;
+        return;
+    }
+
+    const BoundingBox leaf_box = nodes_[leaf].box;
+
+    // Finds the best sibling by descending into the child with the lowest cost.
+    int32_t index = root_;
+
+    while (!nodes_[index].IsLeaf()) {
+        const Node &node = nodes_[index];
+
+        const float area = SurfaceArea(node.box);
+        const float combined_area = SurfaceArea(Union(node.box, leaf_box));
+
+        // Cost of creating a new parent for the node and the leaf.
+        const float cost = 2 * combined_area;
+
+        // Minimum cost of pushing the leaf further down the tree.
+        const float inheritance_cost = 2 * (combined_area - area);
+
+        float child_costs[2];
+
+        for (int child = 0; child < 2; child++) {
+            const Node &child_node = nodes_[node.children[child]];
+            const float enlarged_area = SurfaceArea(Union(child_node.box, leaf_box));
+
+            child_costs[child] = (child_node.IsLeaf() ? enlarged_area : enlarged_area - SurfaceArea(child_node.box)) +
+                                 inheritance_cost;
+        }
+
+        if (cost < child_costs[0] && cost < child_costs[1])
+            break;
+
+        index = child_costs[0] < child_costs[1] ? node.children[0] : node.children[1];
+    }
+
+    const int32_t sibling = index;
+
+    // Allocated before the nodes are referenced, as it may grow the nodes.
+    const int32_t new_parent = AllocateNode();
+    const int32_t old_parent = nodes_[sibling].parent;
+
+    Node &parent_node = nodes_[new_parent];
+    parent_node.parent = old_parent;
+    parent_node.box = Union(leaf_box, nodes_[sibling].box);
+    parent_node.height = nodes_[sibling].height + 1;
+    parent_node.children[0] = sibling;
+    parent_node.children[1] = leaf;
+
+    if (old_parent != kNullNode) {
+        int32_t *children = nodes_[old_parent].children;
+        children[children[0] == sibling ? 0 : 1] = new_parent;
+    } else
+        root_ = new_parent;
+
+    nodes_[sibling].parent = new_parent;
+    nodes_[leaf].parent = new_parent;
+
+    UpdateAncestors(new_parent);
+}
+
+void DynamicBvh::RemoveLeaf(int32_t leaf) {
+    if (leaf == root_) {
+        root_ = kNullNode;
+        return;
+    }
+
+    const int32_t parent = nodes_[leaf].parent;
+    const int32_t grand_parent = nodes_[parent].parent;
+
+    const int32_t *parent_children = nodes_[parent].children;
+    const int32_t sibling = parent_children[0] == leaf ? parent_children[1] : parent_children[0];
+
+    nodes_[sibling].parent = grand_parent;
+    FreeNode(parent);
+
+    if (grand_parent == kNullNode) {
+        root_ = sibling;
+        return;
+    }
+
+    int32_t *children = nodes_[grand_parent].children;
+    children[children[0] == parent ? 0 : 1] = sibling;
+
+    UpdateAncestors(grand_parent);
+}
+
+void DynamicBvh::UpdateAncestors(int32_t node) {
+    while (node != kNullNode) {
+        node = Balance(node);
+        UpdateFromChildren(node);
+
+        node = nodes_[node].parent;
+    }
+}
+
+int32_t DynamicBvh::Balance(int32_t a_index) {
+    Node &a = nodes_[a_index];
+    if (a.IsLeaf() || a.height < 2)
+        return a_index;
+
+    const int32_t b_index = a.children[0];
+    const int32_t c_index = a.children[1];
+    Node &b = nodes_[b_index];
+    Node &c = nodes_[c_index];
+
+    const int32_t balance = c.height - b.height;
+
+    // Rotates the higher child up, and moves its higher child under the node.
+    const auto rotate = [&](int32_t up_index, int32_t side) {
+        Node &up = nodes_[up_index];
+
+        const int32_t f_index = up.children[0];
+        const int32_t g_index = up.children[1];
+        Node &f = nodes_[f_index];
+        Node &g = nodes_[g_index];
+
+        up.children[0] = a_index;
+        up.parent = a.parent;
+        a.parent = up_index;
+
+        if (up.parent != kNullNode) {
+            int32_t *children = nodes_[up.parent].children;
+            children[children[0] == a_index ? 0 : 1] = up_index;
+        } else
+            root_ = up_index;
+
+        // The higher grandchild stays under the rotated child, the other one replaces it under the node.
+        const bool f_higher = f.height > g.height;
+        const int32_t kept_index = f_higher ? f_index : g_index;
+        const int32_t moved_index = f_higher ? g_index : f_index;
+
+        up.children[1] = kept_index;
+        a.children[side] = moved_index;
+        nodes_[moved_index].parent = a_index;
+
+        UpdateFromChildren(a_index);
+        UpdateFromChildren(up_index);
+    };
+
+    if (balance > 1) {
+        rotate(c_index, 1);
+        return c_index;
+    }
+
+    if (balance < -1) {
+        rotate(b_index, 0);
+        return b_index;
+    }
+
+    return a_index;
+}
+
+void DynamicBvh::UpdateFromChildren(int32_t node) {
+    Node &parent = nodes_[node];
+    const Node &child1 = nodes_[parent.children[0]];
+    const Node &child2 = nodes_[parent.children[1]];
+
+    parent.box = Union(child1.box, child2.box);
+    parent.height = 1 + std::max(child1.height, child2.height);
+}
+
+BoundingBox DynamicBvh::Enlarge(const BoundingBox &box) {
+    const Vector3 half_extents = box.GetHalfExtents();
+    const float margin = kFatBoxMargin * std::max({half_extents.x, half_extents.y, half_extents.z});
+
+    const Vector3 margins(margin, margin, margin);
+
+    return BoundingBox{box.min - margins, box.max + margins};
+}
+
+BoundingBox DynamicBvh::Union(const BoundingBox &a, const BoundingBox &b) {
+    BoundingBox box;
+
+    for (int axis = 0; axis < 3; axis++) {
+        box.min[axis] = std::min(a.min[axis], b.min[axis]);
+        box.max[axis] = std::max(a.max[axis], b.max[axis]);
+    }
+
+    return box;
+}
+
+float DynamicBvh::SurfaceArea(const BoundingBox &box) {
+    const Vector3 size = box.max - box.min;
+
+    return 2 * (size.x * size.y + size.y * size.z + size.z * size.x);
+}
+
+bool DynamicBvh::Contains(const BoundingBox &outer, const BoundingBox &inner) {
+    for (int axis = 0; axis < 3; axis++) {
+        if (inner.min[axis] < outer.min[axis] || inner.max[axis] > outer.max[axis])
+            return false;
+    }
+
+    return true;
+}
+
+bool DynamicBvh::Overlap(const BoundingBox &a, const BoundingBox &b) {
+    for (int axis = 0; axis < 3; axis++) {
+        if (a.max[axis] < b.min[axis] || b.max[axis] < a.min[axis])
+            return false;
+    }
+
+    return true;
+}
+
+float DynamicBvh::IntersectRay(const BoundingBox &box, const Vector3 &origin, const Vector3 &inverse_direction,
+                               float max_distance) {
+    float enter = 0;
+    float exit = max_distance;
+
+    // Slab test. A ray in the plane of a slab gives NaN, which std::min and std::max ignore here.
+    for (int axis = 0; axis < 3; axis++) {
+        const float t1 = (box.min[axis] - origin[axis]) * inverse_direction[axis];
+        const float t2 = (box.max[axis] - origin[axis]) * inverse_direction[axis];
+
+        enter = std::max(enter, std::min(t1, t2));
+        exit = std::min(exit, std::max(t1, t2));
+    }
+
+    return enter <= exit ? enter : -1;
+}
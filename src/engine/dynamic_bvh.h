@@ -0,0 +1,291 @@
+#pragma once
+
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "math/bounding_volumes.h"
+#include "math/frustum.h"
+
+/**
+ * Dynamic bounding volume hierarchy of axis-aligned boxes, for queries over many moving objects.
+ *
+ * Every leaf holds an enlarged (fat) copy of the box it is given, so small movements don't change the tree.
+ * A leaf whose box leaves its fat box is reinserted, and the ancestors are rebalanced with tree rotations,
+ * which keeps the tree quality under any motion, unlike refitting the boxes in place.
+ *
+ * The queries report the user data of the leaves and test the fat boxes, so they are conservative.
+ * They reuse the traversal stacks of the tree, so they must not run concurrently or from a query callback.
+ */
+class DynamicBvh {
+public:
+    static constexpr int32_t kNullNode = -1;
+
+    // Creates a leaf and returns it. The leaf keeps its id until it's removed.
+    int32_t Insert(const BoundingBox &box, uint32_t user_data);
+
+    void Remove(int32_t leaf);
+
+    /**
+     * Moves the leaf to the box.
+     *
+     * @return True if the leaf was reinserted: the box left the fat box of the leaf, or is much smaller than it.
+     */
+    bool Update(int32_t leaf, const BoundingBox &box);
+
+    // Whether Update would reinsert the leaf. It only reads the tree, so it may run on multiple threads.
+    bool NeedsUpdate(int32_t leaf, const BoundingBox &box) const;
+
+    uint32_t GetUserData(int32_t leaf) const;
+
+    const BoundingBox &GetFatBox(int32_t leaf) const;
+
+    size_t GetLeavesCount() const;
+
+    // Height of the tree, zero for a single leaf.
+    int32_t GetHeight() const;
+
+public:
+    /**
+     * Calls callback(user_data, fully_inside) for the leaves that may intersect the frustum.
+     * Subtrees fully inside the frustum are reported without testing their leaves.
+     */
+    template<typename Callback>
+    void QueryFrustum(const Frustum &frustum, Callback &&callback) const;
+
+    // Calls callback(user_data) for the leaves that overlap the box.
+    template<typename Callback>
+    void QueryBox(const BoundingBox &box, Callback &&callback) const;
+
+    /**
+     * Calls callback(user_data, max_distance) for the leaves that the ray from the origin hits within the distance,
+     * nearer subtrees first. The distance is measured in the units of the direction. The callback returns the new
+     * maximum distance, e.g. the distance of a hit it found, which prunes the farther leaves.
+     */
+    template<typename Callback>
+    void QueryRay(const Vector3 &origin, const Vector3 &direction, float max_distance, Callback &&callback) const;
+
+private:
+    struct Node {
+        BoundingBox box;
+
+        // The next free node when the node is free.
+        int32_t parent;
+
+        int32_t children[2];
+
+        // Zero for the leaves, -1 for the free nodes.
+        int32_t height;
+
+        uint32_t user_data;
+
+        bool IsLeaf() const {
+            return children[0] == kNullNode;
+        }
+    };
+
+    // Node with the mask of the frustum planes its box may cross. The box is inside the other planes.
+    struct FrustumEntry {
+        int32_t node;
+        uint32_t planes_mask;
+    };
+
+    // Node with the distance along the ray where the ray enters its box.
+    struct RayEntry {
+        int32_t node;
+        float distance;
+    };
+
+    // Relative margin of the fat boxes, per axis of the largest half extent.
+    static constexpr float kFatBoxMargin = 0.1f;
+
+    int32_t AllocateNode();
+
+    void FreeNode(int32_t node);
+
+    void InsertLeaf(int32_t leaf);
+
+    void RemoveLeaf(int32_t leaf);
+
+    // Recomputes the boxes and the heights of the ancestors of the node, balancing them on the way up.
+    void UpdateAncestors(int32_t node);
+
+    // Rotates the node if it's unbalanced, and returns the node that takes its place.
+    int32_t Balance(int32_t node);
+
+    void UpdateFromChildren(int32_t node);
+
+    static BoundingBox Enlarge(const BoundingBox &box);
+
+    static BoundingBox Union(const BoundingBox &a, const BoundingBox &b);
+
+    static float SurfaceArea(const BoundingBox &box);
+
+    static bool Contains(const BoundingBox &outer, const BoundingBox &inner);
+
+    static bool Overlap(const BoundingBox &a, const BoundingBox &b);
+
+    // Distance along the ray where it enters the box, or a negative value if it misses the box within the distance.
+    static float IntersectRay(const BoundingBox &box, const Vector3 &origin, const Vector3 &inverse_direction,
+                              float max_distance);
+
+private:
+    std::vector<Node> nodes_;
+
+    int32_t root_ = kNullNode;
+    int32_t free_list_ = kNullNode;
+
+    size_t leaves_count_ = 0;
+
+    // Traversal stacks of the queries, kept to not allocate them on every query.
+    mutable std::vector<FrustumEntry> frustum_stack_;
+    mutable std::vector<RayEntry> ray_stack_;
+    mutable std::vector<int32_t> node_stack_;
+};
+
+template<typename Callback>
+void DynamicBvh::QueryFrustum(const Frustum &frustum, Callback &&callback) const {
+    if (root_ == kNullNode)
+        return;
+
+    const std::array<Plane, Frustum::kPlanesCount> &planes = frustum.GetPlanes();
+
+    constexpr uint32_t kAllPlanes = (1u << Frustum::kPlanesCount) - 1;
+
+    std::vector<FrustumEntry> &stack = frustum_stack_;
+    stack.clear();
+    stack.push_back({root_, kAllPlanes});
+
+    std::vector<int32_t> &inside_stack = node_stack_;
+    inside_stack.clear();
+
+    while (!stack.empty()) {
+        const FrustumEntry entry = stack.back();
+        stack.pop_back();
+
+        const Node &node = nodes_[entry.node];
+        const Vector3 center = node.box.GetCenter();
+        const Vector3 half_extents = node.box.GetHalfExtents();
+
+        uint32_t planes_mask = entry.planes_mask;
+        bool outside = false;
+
+        // The plane normals point out of the frustum.
+        for (uint32_t plane = 0; plane < Frustum::kPlanesCount && !outside; plane++) {
+            if ((planes_mask & (1u << plane)) == 0)
+                continue;
+
+            const Vector3 &normal = planes[plane].GetNormal();
+            const float radius = std::abs(normal.x) * half_extents.x +
+                                 std::abs(normal.y) * half_extents.y +
+                                 std::abs(normal.z) * half_extents.z;
+
+            const float distance = planes[plane].DistanceTo(center);
+
+            if (distance > radius)
+                outside = true;
+            else if (distance <= -radius)
+                planes_mask &= ~(1u << plane);
+        }
+
+        if (outside)
+            continue;
+
+        if (planes_mask == 0) {
+            // Every leaf of the subtree is inside.
+            inside_stack.push_back(entry.node);
+
+            while (!inside_stack.empty()) {
+                const Node &inside_node = nodes_[inside_stack.back()];
+                inside_stack.pop_back();
+
+                if (inside_node.IsLeaf())
+                    callback(inside_node.user_data, true);
+                else {
+                    inside_stack.push_back(inside_node.children[1]);
+                    inside_stack.push_back(inside_node.children[0]);
+                }
+            }
+        } else if (node.IsLeaf())
+            callback(node.user_data, false);
+        else {
+            stack.push_back({node.children[1], planes_mask});
+            stack.push_back({node.children[0], planes_mask});
+        }
+    }
+}
+
+template<typename Callback>
+void DynamicBvh::QueryBox(const BoundingBox &box, Callback &&callback) const {
+    if (root_ == kNullNode)
+        return;
+
+    std::vector<int32_t> &stack = node_stack_;
+    stack.clear();
+    stack.push_back(root_);
+
+    while (!stack.empty()) {
+        const Node &node = nodes_[stack.back()];
+        stack.pop_back();
+
+        if (!Overlap(node.box, box))
+            continue;
+
+        if (node.IsLeaf())
+            callback(node.user_data);
+        else {
+            stack.push_back(node.children[1]);
+            stack.push_back(node.children[0]);
+        }
+    }
+}
+
+template<typename Callback>
+void DynamicBvh::QueryRay(const Vector3 &origin, const Vector3 &direction, float max_distance,
+                          Callback &&callback) const {
+    if (root_ == kNullNode)
+        return;
+
+    // Infinite for the axes the ray is parallel to.
+    const Vector3 inverse_direction(1 / direction.x, 1 / direction.y, 1 / direction.z);
+
+    std::vector<RayEntry> &stack = ray_stack_;
+    stack.clear();
+
+    const float root_distance = IntersectRay(nodes_[root_].box, origin, inverse_direction, max_distance);
+    if (root_distance >= 0)
+        stack.push_back({root_, root_distance});
+
+    while (!stack.empty()) {
+        const RayEntry entry = stack.back();
+        stack.pop_back();
+
+        if (entry.distance > max_distance)
+            continue; // A nearer hit was found after the node was pushed.
+
+        const Node &node = nodes_[entry.node];
+
+        if (node.IsLeaf()) {
+            max_distance = callback(node.user_data, max_distance);
+            continue;
+        }
+
+        RayEntry children[2];
+        for (int child = 0; child < 2; child++) {
+            const int32_t child_node = node.children[child];
+            children[child] = {child_node, IntersectRay(nodes_[child_node].box, origin, inverse_direction,
+                                                        max_distance)};
+        }
+
+        // The nearer child is pushed last, so it's visited first.
+        if (children[0].distance >= 0 && children[1].distance >= 0 && children[0].distance < children[1].distance)
+            std::swap(children[0], children[1]);
+
+        for (const RayEntry &child : children) {
+            if (child.distance >= 0)
+                stack.push_back(child);
+        }
+    }
+}
@@ -1,17 +1,67 @@
+#include <algorithm>
 #include <cassert>
-#include <unordered_map>
-#include <string>
+#include <type_traits>
 
 #include "engine.h"
 #include "math/graphics_utils.h"
 #include "math/frustum.h"
-#include "render/renderer_2d.h"
+#include "math/clip_polygon.h"
+#include "math/clip_space.h"
+#include "math/matrix_transform.h"
+#include "math/simd/simd.h"
+#include "profiler/profiler.h"
+
+namespace {
+
+    // Point in clip space with the shading of its corner, so that clipping interpolates the shading as well.
+    struct ShadedPoint {
+        Vector4 position;
+        float shading;
+
+        ShadedPoint operator+(const ShadedPoint &other) const {
+            return ShadedPoint{position + other.position, shading + other.shading};
+        }
+
+        ShadedPoint operator-(const ShadedPoint &other) const {
+            return ShadedPoint{position - other.position, shading - other.shading};
+        }
+
+        ShadedPoint operator*(float scale) const {
+            return ShadedPoint{position * scale, shading * scale};
+        }
+    };
+
+}
+
+static const Vector4 &GetClipPosition(const Vector4 &point) {
+    return point;
+}
+
+static const Vector4 &GetClipPosition(const ShadedPoint &point) {
+    return point.position;
+}
+
+// Brightness of a face, from the cosine between its normal and the direction to it. Both sides are lit.
+static float ComputeShading(float normal_dot) {
+    return 0.7f + 0.3f * std::min(std::abs(normal_dot), 1.0f);
+}
+
+static Color ShadeColor(const Color &color, float shading) {
+    return Color(static_cast<uint8_t>(static_cast<float>(color.r) * shading),
+                 static_cast<uint8_t>(static_cast<float>(color.g) * shading),
+                 static_cast<uint8_t>(static_cast<float>(color.b) * shading),
+                 color.a);
+}
 
 void Engine::Initialize(const ViewPort &viewport, std::shared_ptr<render::Renderer> &renderer) {
     renderer_ = renderer;
+    renderer_2d_ = std::make_unique<render::Renderer2D>(renderer_.get());
 
     world_ = std::make_shared<World>();
 
+    if (!job_system_)
+        job_system_ = std::make_shared<jobs::JobSystem>();
+
     auto camera = std::make_shared<Camera>();
     camera->Initialize(CameraInitializationParameters{
             .aspect_ratio = viewport.GetAspectRatio()
@@ -26,23 +76,23 @@ void Engine::Initialize(const ViewPort &viewport, std::shared_ptr<render::Render
     SetDefaultSettings();
 }
 
-extern std::unordered_map<std::string, CameraInfo> *cameras; // TODO: remove it
-
 void Engine::Draw() {
+    PROFILE_SCOPE("Draw");
+
     view_->UpdateMatrices();
 
-    render::Renderer2D renderer(renderer_.get());
+    render::Renderer2D &renderer = *renderer_2d_;
 
-    Frustum frustum;
-    frustum.SetFromModelViewProjection(view_->GetViewData().view_projection_matrix);
-    frustum.Invert();
+    statistics_ = PipelineStatistics();
+    renderer.ResetStatistics();
 
-    const auto to_screen = [&](const Vector3 &world_pos) -> Vector2 {
-        Vector4 point = view_->GetViewData().view_projection_matrix * world_pos.AsVec4();
+    const Matrix4 &view_projection_matrix = view_->GetViewData().view_projection_matrix;
+    const simd::Kernels &kernels = simd::GetKernels();
 
-        assert(point[3] > 0 && "W value must be greater than zero");
+    const auto to_screen = [&](const Vector4 &clip_pos) -> Vector3 {
+        assert(clip_pos[3] > 0 && "W value must be greater than zero");
 
-        point /= point[3];
+        const Vector4 point = clip_pos / clip_pos[3];
 
         assert(math::IsInRange(point[0], -1.0f, 1.0f, math::kLargeEpsilon) && "X value is not in range [-1,1]");
         assert(math::IsInRange(point[1], -1.0f, 1.0f, math::kLargeEpsilon) && "Y value is not in range [-1,1]");
@@ -51,170 +101,305 @@ void Engine::Draw() {
 //        point = screen_space_matrix_ * point;
 
         const ViewPort &viewport = view_->GetViewPort();
-        return Vector2(viewport.width / 2 * (1 + point[0]), viewport.height / 2 * (1 - point[1]));
+        return Vector3(viewport.width / 2 * (1 + point[0]), viewport.height / 2 * (1 - point[1]), point[2]);
     };
 
-    const auto draw_line = [&](Vector3 from, Vector3 to, const Color &color) {
-        for (const Plane &clipping_plane : frustum.GetPlanes()) {
-            Plane::Intersection intersection = clipping_plane.IntersectLine(from, to);
-            if (intersection.Exists()) {
-                if (clipping_plane.IsOutside(from))
-                    from = intersection.point;
-                else
-                    to = intersection.point;
-            } else if (clipping_plane.IsOutside(from))
+    // Draws a line given in clip space.
+    const auto draw_line = [&](render::PrimitiveBatch &batch, Vector4 from, Vector4 to, const Color &color) {
+        for (uint32_t plane = 0; plane < clip_space::kPlanesCount; plane++) {
+            const float from_distance = clip_space::Distance(from, static_cast<clip_space::PlaneType>(plane));
+            const float to_distance = clip_space::Distance(to, static_cast<clip_space::PlaneType>(plane));
+
+            if (from_distance < 0 && to_distance < 0)
                 return; // Both points outside the plane and the frustum. Skip.
+
+            if (from_distance < 0)
+                from = to + (from - to) * (to_distance / (to_distance - from_distance));
+            else if (to_distance < 0)
+                to = from + (to - from) * (from_distance / (from_distance - to_distance));
         }
 
-        renderer.DrawLine(to_screen(from), to_screen(to), color);
+        batch.DrawLine(to_screen(from), to_screen(to), color);
     };
 
-    const auto draw_clipped_triangles = [&](std::list<std::array<Vector3, 3>> &triangles, const Color &color) {
-        for (const std::array<Vector3, 3> &triangle : triangles) {
-            Vector2 screen_pos[3] = {to_screen(triangle[0]),
-                                     to_screen(triangle[1]),
-                                     to_screen(triangle[2])};
-
-            renderer.DrawTriangle(screen_pos[0],
-                                  screen_pos[1],
-                                  screen_pos[2],
-                                  color);
-
-            DebugSettings::TriangleSettings &triangle_settings = settings_.debug.clipped_triangle;
-
-            if (triangle_settings.normals.show) {
-                const Color normals_color = triangle_settings.normals.color;
-                const Vector3 clipped_triangle_center = (triangle[0] + triangle[1] + triangle[2]) / 3;
-                Vector3 clipped_triangle_normal = (triangle[1] - triangle[0]).Cross(triangle[2] - triangle[0]);
-                clipped_triangle_normal *= triangle_settings.normals.length / clipped_triangle_normal.GetLength();
-                draw_line(clipped_triangle_center, clipped_triangle_center + clipped_triangle_normal, normals_color);
-            }
+    const auto draw_clipped_triangle = [&](render::PrimitiveBatch &batch,
+                                           const Vector4 &p1, const Vector4 &p2, const Vector4 &p3,
+                                           const Color &c1, const Color &c2, const Color &c3,
+                                           const Vector4 &clip_normal) {
+        Vector3 screen_pos[3] = {to_screen(p1),
+                                 to_screen(p2),
+                                 to_screen(p3)};
+
+        batch.DrawTriangle(screen_pos[0],
+                           screen_pos[1],
+                           screen_pos[2],
+                           c1, c2, c3);
+
+        const DebugSettings::TriangleSettings &triangle_settings = settings_.debug.clipped_triangle;
+
+        if (triangle_settings.normals.show) {
+            const Color normals_color = triangle_settings.normals.color;
+            const Vector4 clipped_triangle_center = (p1 + p2 + p3) / 3;
+            draw_line(batch, clipped_triangle_center, clipped_triangle_center + clip_normal, normals_color);
+        }
 
-            if (triangle_settings.outlines.show) {
-                const Color outlines_color = triangle_settings.outlines.color;
-                renderer.DrawLine(screen_pos[0], screen_pos[1], outlines_color);
-                renderer.DrawLine(screen_pos[0], screen_pos[2], outlines_color);
-                renderer.DrawLine(screen_pos[1], screen_pos[2], outlines_color);
-            }
+        if (triangle_settings.outlines.show) {
+            const Color outlines_color = triangle_settings.outlines.color;
+            batch.DrawLine(screen_pos[0], screen_pos[1], outlines_color);
+            batch.DrawLine(screen_pos[0], screen_pos[2], outlines_color);
+            batch.DrawLine(screen_pos[1], screen_pos[2], outlines_color);
         }
     };
 
-    const auto clip_triangles = [&](std::list<std::array<Vector3, 3>> &triangles) {
-        for (const Plane &clipping_plane : frustum.GetPlanes()) {
-            for (auto it = triangles.begin(); it != triangles.end();) {
-                std::array<Vector3, 3> &triangle_points = *it;
-
-                Vector3 inside_points[3];
-                uint32_t inside_points_count = 0;
-                Vector3 outside_points[3];
-                uint32_t outside_points_count = 0;
-
-                for (const Vector3 &point : triangle_points) {
-                    if (clipping_plane.IsOutside(point))
-                        outside_points[outside_points_count++] = point;
-                    else
-                        inside_points[inside_points_count++] = point;
+    {
+        // Draw objects
+        {
+            PROFILE_SCOPE("Bounds");
+            world_->UpdateBounds(job_system_.get());
+        }
+
+        {
+            PROFILE_SCOPE("Cull");
+
+            Frustum view_frustum;
+            view_frustum.SetFromModelViewProjection(view_projection_matrix);
+
+            world_->QueryFrustum(view_frustum, &visible_objects_);
+        }
+
+        const Vector3 camera_world_position = view_->GetCamera()->GetWorldPosition();
+
+        // The objects the hierarchy didn't return are outside of the frustum.
+        statistics_.objects_visited = world_->GetObjectsCount();
+        statistics_.objects_culled = world_->GetObjectsCount() - visible_objects_.size();
+
+        for (const World::FrustumQueryResult &visible_object : visible_objects_) {
+            const World::ObjectHandle object = visible_object.object;
+            const std::shared_ptr<Mesh> &mesh = world_->GetMesh(object);
+            if (!world_->IsVisible(object) || !mesh) {
+                statistics_.objects_skipped++;
+                continue;
+            }
+
+            const Matrix4 model_matrix = world_->GetModelMatrix(object);
+            Matrix4 model_view_projection_matrix;
+            kernels.multiply_matrices(view_projection_matrix, model_matrix, &model_view_projection_matrix);
+
+            // The hierarchy only tests the world space boxes of the objects, the bounds in the object space are tighter.
+            Frustum::Containment containment = Frustum::Containment::kInside;
+
+            if (!visible_object.fully_inside) {
+                PROFILE_SCOPE("Cull");
+
+                // The frustum planes are in the object space, like the bounds of the mesh.
+                Frustum frustum;
+                frustum.SetFromModelViewProjection(model_view_projection_matrix);
+
+                const Mesh::Bounds &bounds = mesh->GetBounds();
+
+                containment = frustum.Contains(bounds.sphere);
+                if (containment == Frustum::Containment::kIntersecting)
+                    containment = frustum.Contains(bounds.box);
+            }
+
+            if (containment == Frustum::Containment::kOutside) {
+                statistics_.objects_culled++;
+                continue;
+            }
+
+            statistics_.faces_in += mesh->GetFacesCount();
+
+            // The faces of an object fully inside the frustum don't need to be clipped.
+            const bool clip = containment == Frustum::Containment::kIntersecting;
+
+            // The model matrix is rigid, so the shading can be done in the object space.
+            const Vector3 camera_position = matrix::InvertRigid(model_matrix) * camera_world_position;
+
+            const memory::ArrayView<Mesh::Vertex> vertices = mesh->GetVertices();
+            const memory::ArrayView<Mesh::FacePlane> face_planes = mesh->GetFacePlanes();
+
+            const bool smooth_shading = settings_.shading == Shading::kSmooth && mesh->HasNormals();
+            const memory::ArrayView<Vector3> normals = mesh->GetNormals();
+            const IndexBuffer &normal_indices = mesh->GetNormalIndices();
+
+            const Color color0 = world_->GetColor(object);
+
+            const bool show_normals = settings_.debug.clipped_triangle.normals.show;
+            const float normals_length = settings_.debug.clipped_triangle.normals.length;
+
+            const CullMode cull_mode = settings_.cull_mode;
+
+            CullClusters(*mesh, camera_position);
+            TransformVertices(*mesh, model_view_projection_matrix, clip);
+
+            // Clips the triangle by the planes it crosses, and draws the triangles of the remaining polygon.
+            const auto clip_triangle = [&](PipelineStatistics &statistics, const auto &p1, const auto &p2,
+                                           const auto &p3, clip_space::Outcode crossed_planes, const auto &draw) {
+                using Point = std::decay_t<decltype(p1)>;
+
+                if (crossed_planes == clip_space::kInside) {
+                    // The triangle is fully inside, no clipping needed.
+                    draw(p1, p2, p3);
+                    return;
                 }
 
-                assert(inside_points_count + outside_points_count == 3);
+                statistics.faces_clipped++;
+
+                ClipPolygon<Point> polygon(p1, p2, p3);
 
-                if (inside_points_count == 0) {
-                    it = triangles.erase(it);
-                    continue;
+                for (uint32_t plane = 0; plane < clip_space::kPlanesCount && !polygon.IsEmpty(); plane++) {
+                    if ((crossed_planes & (1u << plane)) == 0)
+                        continue;
+
+                    polygon.Clip([&](const Point &point) {
+                        return clip_space::Distance(GetClipPosition(point), static_cast<clip_space::PlaneType>(plane));
+                    });
                 }
 
-                if (outside_points_count == 0) {
-                    ++it;
-                    continue;
+                if (polygon.IsEmpty()) {
+                    statistics.faces_clipped_away++;
+                    return;
                 }
 
-                if (inside_points_count == 1) {
-                    Plane::Intersection intersection1 = clipping_plane.IntersectLine(inside_points[0],
-                                                                                     outside_points[0]);
-                    Plane::Intersection intersection2 = clipping_plane.IntersectLine(inside_points[0],
-                                                                                     outside_points[1]);
-
-                    assert(intersection1.Exists());
-                    assert(intersection2.Exists());
-
-                    triangle_points = {inside_points[0], intersection1.Point(), intersection2.Point()};
-                } else {
-                    assert(inside_points_count == 2);
-
-                    Plane::Intersection intersection1 = clipping_plane.IntersectLine(inside_points[0],
-                                                                                     outside_points[0]);
-                    Plane::Intersection intersection2 = clipping_plane.IntersectLine(inside_points[1],
-                                                                                     outside_points[0]);
-                    assert(intersection1.Exists());
-                    assert(intersection2.Exists());
-
-                    triangle_points = {inside_points[0], intersection1.Point(), inside_points[1]};
-                    triangles.emplace(it, std::array<Vector3, 3>{intersection1.Point(),
-                                                                 intersection2.Point(), inside_points[1]});
+                polygon.ForEachTriangle([&](const Point &c1, const Point &c2, const Point &c3) {
+                    draw(c1, c2, c3);
+                    statistics.triangles_generated++;
+                });
+            };
+
+            // Faces are processed by multiple threads, so the face must only write to its batch.
+            const auto draw_face = [&](render::PrimitiveBatch &batch, PipelineStatistics &statistics, size_t face,
+                                       uint32_t i1, uint32_t i2, uint32_t i3) {
+                const Mesh::FacePlane &plane = face_planes[face];
+
+                if (IsFaceCulled(plane, camera_position, cull_mode)) {
+                    statistics.faces_culled++;
+                    return;
                 }
-                ++it;
-            }
-        }
-    };
 
-    const auto draw_triangle = [&](const Vector3 &p1, const Vector3 &p2, const Vector3 &p3, const Color &color0) {
-        Vector3 triangle_normal = (p2 - p1).Cross(p3 - p1);
-        triangle_normal.Normalize();
+                clip_space::Outcode crossed_planes = clip_space::kInside;
 
-        const Vector3 triangle_center = (p1 + p2 + p3) / 3;
-        Vector3 direction_to_triangle = triangle_center - view_->GetCamera()->GetWorldPosition();
-        direction_to_triangle.Normalize();
+                if (clip) {
+                    const clip_space::Outcode outcodes[3] = {vertex_outcodes_[i1],
+                                                             vertex_outcodes_[i2],
+                                                             vertex_outcodes_[i3]};
 
-        const float triangle_dot = triangle_normal.Dot(direction_to_triangle);
-        if (triangle_dot > 0)
-            return;
+                    if ((outcodes[0] & outcodes[1] & outcodes[2]) != clip_space::kInside) {
+                        statistics.faces_outside++;
+                        return; // All the points are outside of the same plane.
+                    }
 
-        Color color(static_cast<uint8_t>(static_cast<float>(color0.r) * (0.7f + 0.3f * std::abs(triangle_dot))),
-                    static_cast<uint8_t>(static_cast<float>(color0.g) * (0.7f + 0.3f * std::abs(triangle_dot))),
-                    static_cast<uint8_t>(static_cast<float>(color0.b) * (0.7f + 0.3f * std::abs(triangle_dot))),
-                    color0.a);
+                    crossed_planes = outcodes[0] | outcodes[1] | outcodes[2];
+                }
 
-        std::list<std::array<Vector3, 3>> triangles;
-        triangles.emplace_back(std::array<Vector3, 3>{p1, p2, p3});
+                const Vector3 &p1 = vertices[i1].position;
+                const Vector3 &p2 = vertices[i2].position;
+                const Vector3 &p3 = vertices[i3].position;
 
-        clip_triangles(triangles);
+                const Vector3 &triangle_normal = plane.normal;
 
-        draw_clipped_triangles(triangles, color);
-    };
+                const Vector4 clip_pos[3] = {clip_space_vertices_[i1],
+                                             clip_space_vertices_[i2],
+                                             clip_space_vertices_[i3]};
 
-    {
-        // Draw rigid bodies
-        const std::list<std::shared_ptr<RigidBody>> &bodies = world_->ListObjects();
+                Vector4 clip_normal = Vector4::Zero();
+                if (show_normals)
+                    kernels.transform_vector(model_view_projection_matrix, (triangle_normal * normals_length).AsVec4(0),
+                                             &clip_normal);
 
-        for (const std::shared_ptr<RigidBody> &rigid_body : bodies) {
-            if (!rigid_body->IsVisible())
-                continue;
+                if (smooth_shading) {
+                    const Vector3 *positions[3] = {&p1, &p2, &p3};
+
+                    ShadedPoint points[3];
 
-            const Matrix4 model_matrix = rigid_body->GetModelMatrix();
-            const std::shared_ptr<Mesh> &mesh = rigid_body->GetMesh();
+                    for (uint32_t corner = 0; corner < 3; corner++) {
+                        const Vector3 &normal = normals[normal_indices[face * 3 + corner]];
 
-            const std::vector<Mesh::Vertex> &vertices = mesh->GetVertices();
-            const std::vector<Mesh::Face> &faces = mesh->GetFaces();
+                        Vector3 direction_to_corner = *positions[corner] - camera_position;
+                        direction_to_corner.Normalize();
 
-            const Color color = rigid_body->GetColor();
+                        points[corner] = ShadedPoint{clip_pos[corner], ComputeShading(normal.Dot(direction_to_corner))};
+                    }
+
+                    clip_triangle(statistics, points[0], points[1], points[2], crossed_planes,
+                                  [&](const ShadedPoint &c1, const ShadedPoint &c2, const ShadedPoint &c3) {
+                                      draw_clipped_triangle(batch, c1.position, c2.position, c3.position,
+                                                            ShadeColor(color0, c1.shading),
+                                                            ShadeColor(color0, c2.shading),
+                                                            ShadeColor(color0, c3.shading), clip_normal);
+                                  });
+                    return;
+                }
 
-            for (const Mesh::Face &face : faces) {
-                std::array<Vector3, 3> position;
+                const Vector3 triangle_center = (p1 + p2 + p3) / 3;
+                Vector3 direction_to_triangle = triangle_center - camera_position;
+                direction_to_triangle.Normalize();
 
-                for (uint32_t i = 0; i < 3; i++)
-                    position[i] = model_matrix * vertices[face.indices[i]].position;
+                const Color color = ShadeColor(color0, ComputeShading(triangle_normal.Dot(direction_to_triangle)));
 
-                draw_triangle(position[0], position[1], position[2], color);
+                clip_triangle(statistics, clip_pos[0], clip_pos[1], clip_pos[2], crossed_planes,
+                              [&](const Vector4 &c1, const Vector4 &c2, const Vector4 &c3) {
+                                  draw_clipped_triangle(batch, c1, c2, c3, color, color, color, clip_normal);
+                              });
+            };
+
+            const size_t faces_count = mesh->GetFacesCount();
+            const size_t batches_count = (faces_count + kFacesBatchSize - 1) / kFacesBatchSize;
+
+            if (face_batches_.size() < batches_count) {
+                face_batches_.resize(batches_count);
+                face_batch_statistics_.resize(batches_count);
+            }
+
+            {
+                PROFILE_SCOPE("Clip and shade");
+
+                job_system_->ParallelFor(faces_count, kFacesBatchSize, [&](size_t begin, size_t end) {
+                    PROFILE_SCOPE("Faces batch");
+
+                    render::PrimitiveBatch &batch = face_batches_[begin / kFacesBatchSize];
+
+                    // Counted locally, as the statistics of the neighbouring batches share cache lines.
+                    PipelineStatistics statistics;
+
+                    // Instantiated once per index type of the mesh.
+                    mesh->GetIndices().Visit([&](const auto *indices, size_t) {
+                        for (size_t first_face = begin; first_face < end; first_face += Mesh::kClusterSize) {
+                            const size_t end_face = std::min(first_face + Mesh::kClusterSize, end);
+
+                            if (!visible_clusters_[first_face / Mesh::kClusterSize]) {
+                                statistics.faces_culled += end_face - first_face;
+                                continue;
+                            }
+
+                            for (size_t face = first_face; face < end_face; face++) {
+                                draw_face(batch, statistics, face,
+                                          indices[face * 3], indices[face * 3 + 1], indices[face * 3 + 2]);
+                            }
+                        }
+                    });
+
+                    face_batch_statistics_[begin / kFacesBatchSize] = statistics;
+                });
+            }
+
+            PROFILE_SCOPE("Submit");
+
+            for (size_t i = 0; i < batches_count; i++) {
+                renderer.Append(face_batches_[i]);
+                face_batches_[i].Clear();
+
+                statistics_ += face_batch_statistics_[i];
             }
         }
     }
 
-    {
+    if (debug_cameras_) {
         // Draw camera frustums.
 
         std::shared_ptr<Camera> active_camera = GetActiveCamera();
 
-        for (const auto &p : *cameras) {
+        for (const auto &p : *debug_cameras_) {
             const CameraInfo &camera_info = p.second;
             if (!camera_info.show_viewing_frustum)
                 continue;
@@ -231,23 +416,39 @@ void Engine::Draw() {
 
             const Color frustum_color = camera_info.viewing_frustum_color;
 
-            draw_line(corner_points[Frustum::kNearBottomLeft], corner_points[Frustum::kNearTopLeft], frustum_color);
-            draw_line(corner_points[Frustum::kNearBottomLeft], corner_points[Frustum::kNearBottomRight], frustum_color);
-            draw_line(corner_points[Frustum::kNearBottomLeft], corner_points[Frustum::kFarBottomLeft], frustum_color);
+            const auto draw_frustum_edge = [&](Frustum::Corner from, Frustum::Corner to) {
+                draw_line(renderer,
+                          view_projection_matrix * corner_points[from].AsVec4(),
+                          view_projection_matrix * corner_points[to].AsVec4(),
+                          frustum_color);
+            };
 
-            draw_line(corner_points[Frustum::kNearTopRight], corner_points[Frustum::kNearTopLeft], frustum_color);
-            draw_line(corner_points[Frustum::kNearTopRight], corner_points[Frustum::kNearBottomRight], frustum_color);
-            draw_line(corner_points[Frustum::kNearTopRight], corner_points[Frustum::kFarTopRight], frustum_color);
+            draw_frustum_edge(Frustum::kNearBottomLeft, Frustum::kNearTopLeft);
+            draw_frustum_edge(Frustum::kNearBottomLeft, Frustum::kNearBottomRight);
+            draw_frustum_edge(Frustum::kNearBottomLeft, Frustum::kFarBottomLeft);
 
-            draw_line(corner_points[Frustum::kFarBottomRight], corner_points[Frustum::kNearBottomRight], frustum_color);
-            draw_line(corner_points[Frustum::kFarBottomRight], corner_points[Frustum::kFarTopRight], frustum_color);
-            draw_line(corner_points[Frustum::kFarBottomRight], corner_points[Frustum::kFarBottomLeft], frustum_color);
+            draw_frustum_edge(Frustum::kNearTopRight, Frustum::kNearTopLeft);
+            draw_frustum_edge(Frustum::kNearTopRight, Frustum::kNearBottomRight);
+            draw_frustum_edge(Frustum::kNearTopRight, Frustum::kFarTopRight);
 
-            draw_line(corner_points[Frustum::kFarTopLeft], corner_points[Frustum::kNearTopLeft], frustum_color);
-            draw_line(corner_points[Frustum::kFarTopLeft], corner_points[Frustum::kFarTopRight], frustum_color);
-            draw_line(corner_points[Frustum::kFarTopLeft], corner_points[Frustum::kFarBottomLeft], frustum_color);
+            draw_frustum_edge(Frustum::kFarBottomRight, Frustum::kNearBottomRight);
+            draw_frustum_edge(Frustum::kFarBottomRight, Frustum::kFarTopRight);
+            draw_frustum_edge(Frustum::kFarBottomRight, Frustum::kFarBottomLeft);
+
+            draw_frustum_edge(Frustum::kFarTopLeft, Frustum::kNearTopLeft);
+            draw_frustum_edge(Frustum::kFarTopLeft, Frustum::kFarTopRight);
+            draw_frustum_edge(Frustum::kFarTopLeft, Frustum::kFarBottomLeft);
         }
     }
+
+    PROFILE_SCOPE("Submit");
+
+    renderer.Flush();
+
+    const render::Renderer2D::Statistics &submitted = renderer.GetStatistics();
+    statistics_.triangles_submitted = submitted.triangles;
+    statistics_.lines_submitted = submitted.lines;
+    statistics_.draw_calls = submitted.draw_calls;
 }
 
 std::shared_ptr<Camera> Engine::GetActiveCamera() const {
@@ -274,10 +475,17 @@ void Engine::AttachController(const std::shared_ptr<Controller> &controller) {
 }
 
 void Engine::Update(float ts) {
+    PROFILE_SCOPE("Update");
+
     assert(view_->GetCamera());
     view_->GetCamera()->Update(ts);
 
-    UpdateRotationVelocities(ts);
+    {
+        PROFILE_SCOPE("Rotations");
+        world_->UpdateRotations(ts, job_system_.get());
+    }
+
+    PROFILE_SCOPE("Controllers");
 
     for (const std::shared_ptr<Controller> &controller : controllers_)
         controller->Update(ts);
@@ -287,6 +495,10 @@ std::shared_ptr<World> Engine::GetWorld() const {
     return world_;
 }
 
+const PipelineStatistics &Engine::GetPipelineStatistics() const {
+    return statistics_;
+}
+
 Settings *Engine::AccessSettings() {
     return &settings_;
 }
@@ -305,9 +517,126 @@ void Engine::SetDefaultSettings() {
     settings_.debug.clipped_triangle.normals.show = false;
     settings_.debug.clipped_triangle.normals.color = Color::Black();
     settings_.debug.clipped_triangle.normals.length = 1.0f;
+
+    settings_.cull_mode = CullMode::kBack;
+    settings_.shading = Shading::kFlat;
+}
+
+void Engine::SetJobSystem(const std::shared_ptr<jobs::JobSystem> &job_system) {
+    assert(job_system);
+    job_system_ = job_system;
+}
+
+std::shared_ptr<jobs::JobSystem> Engine::GetJobSystem() const {
+    return job_system_;
+}
+
+void Engine::SetDebugCameras(const std::unordered_map<std::string, CameraInfo> *cameras) {
+    debug_cameras_ = cameras;
+}
+
+bool Engine::IsFaceCulled(const Mesh::FacePlane &plane, const Vector3 &camera_position, CullMode cull_mode) {
+    if (cull_mode == CullMode::kNone)
+        return false;
+
+    const bool front_facing = plane.normal.Dot(camera_position) >= plane.distance;
+
+    return front_facing == (cull_mode == CullMode::kFront);
+}
+
+bool Engine::IsClusterCulled(const Mesh::FaceCluster &cluster, const Vector3 &camera_position, CullMode cull_mode) {
+    if (cull_mode == CullMode::kNone)
+        return false;
+
+    const Vector3 to_center = cluster.center - camera_position;
+    const float axis_dot = cluster.cone_axis.Dot(to_center);
+
+    // Every face is seen from behind (or from the front) if every direction from the camera to the bounding sphere
+    // is within 90 degrees minus the cone half-angle from the cone axis (or from the opposite direction).
+    const float bound = cluster.cone_sine * to_center.GetLength() + cluster.radius * (1 + cluster.cone_sine);
+
+    return (cull_mode == CullMode::kBack ? axis_dot : -axis_dot) > bound;
+}
+
+void Engine::CullClusters(const Mesh &mesh, const Vector3 &camera_position) {
+    PROFILE_SCOPE("Cull");
+
+    const memory::ArrayView<Mesh::FaceCluster> clusters = mesh.GetFaceClusters();
+    const memory::ArrayView<uint32_t> cluster_vertex_blocks = mesh.GetClusterVertexBlocks();
+
+    const size_t blocks_count = (mesh.GetVertices().size() + Mesh::kVertexBlockSize - 1) / Mesh::kVertexBlockSize;
+
+    visible_clusters_.resize(clusters.size());
+
+    // Atomics can't be moved, so the blocks are reallocated instead of resized.
+    if (used_vertex_blocks_.size() < blocks_count)
+        used_vertex_blocks_ = std::vector<std::atomic<uint8_t>>(blocks_count);
+
+    for (size_t block = 0; block < blocks_count; block++)
+        used_vertex_blocks_[block].store(0, std::memory_order_relaxed);
+
+    const CullMode cull_mode = settings_.cull_mode;
+
+    job_system_->ParallelFor(clusters.size(), kClustersBatchSize, [&](size_t begin, size_t end) {
+        for (size_t cluster = begin; cluster < end; cluster++) {
+            const bool visible = !IsClusterCulled(clusters[cluster], camera_position, cull_mode);
+
+            visible_clusters_[cluster] = visible;
+            if (!visible)
+                continue;
+
+            const uint32_t first_block = clusters[cluster].first_vertex_block;
+            const uint32_t end_block = first_block + clusters[cluster].vertex_blocks_count;
+
+            for (uint32_t i = first_block; i < end_block; i++) {
+                std::atomic<uint8_t> &block = used_vertex_blocks_[cluster_vertex_blocks[i]];
+
+                // Loaded first, so the threads don't keep writing to the same cache lines.
+                if (!block.load(std::memory_order_relaxed))
+                    block.store(1, std::memory_order_relaxed);
+            }
+        }
+    });
 }
 
-void Engine::UpdateRotationVelocities(float ts) {
-    for (const std::shared_ptr<RigidBody> &body : world_->ListObjects())
-        body->SetRotationAngles(body->GetRotationAngles() + body->GetRotationVelocity() * ts);
-}
\ No newline at end of file
+void Engine::TransformVertices(const Mesh &mesh, const Matrix4 &model_view_projection, bool compute_outcodes) {
+    PROFILE_SCOPE("Transform");
+
+    const memory::ArrayView<Mesh::Vertex> vertices = mesh.GetVertices();
+    const size_t vertices_count = vertices.size();
+
+    clip_space_vertices_.resize(vertices_count);
+    vertex_outcodes_.resize(vertices_count);
+
+    if (vertices_count == 0)
+        return;
+
+    Vector4 *clip_space_vertices = clip_space_vertices_.data();
+    clip_space::Outcode *outcodes = vertex_outcodes_.data();
+
+    const simd::Kernels &kernels = simd::GetKernels();
+    const bool structure_of_arrays = mesh.GetVertexLayout() == Mesh::VertexLayout::kStructureOfArrays;
+
+    job_system_->ParallelFor(vertices_count, kVerticesBatchSize, [&](size_t batch_begin, size_t batch_end) {
+        for (size_t begin = batch_begin; begin < batch_end; begin += Mesh::kVertexBlockSize) {
+            if (!used_vertex_blocks_[begin / Mesh::kVertexBlockSize].load(std::memory_order_relaxed))
+                continue; // Only culled faces use the block.
+
+            const size_t end = std::min(begin + Mesh::kVertexBlockSize, batch_end);
+
+            if (structure_of_arrays) {
+                const Mesh::VertexStreams &streams = mesh.GetVertexStreams();
+                kernels.transform_points_soa(model_view_projection,
+                                             streams.x.data() + begin, streams.y.data() + begin,
+                                             streams.z.data() + begin, clip_space_vertices + begin, end - begin);
+            } else
+                kernels.transform_points(model_view_projection, &vertices[begin].position, sizeof(Mesh::Vertex),
+                                         clip_space_vertices + begin, end - begin);
+
+            if (compute_outcodes) {
+                for (size_t i = begin; i < end; i++)
+                    outcodes[i] = clip_space::ComputeOutcode(clip_space_vertices[i]);
+            }
+        }
+    });
+}
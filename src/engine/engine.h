@@ -1,7 +1,10 @@
 #pragma once
 
+#include <atomic>
 #include <memory>
 #include <list>
+#include <string>
+#include <unordered_map>
 
 #include "world.h"
 #include "camera.h"
@@ -9,12 +12,17 @@
 #include "math/matrix.h"
 #include "controller.h"
 #include "render/renderer.h"
+#include "render/renderer_2d.h"
 #include "settings.h"
+#include "pipeline_statistics.h"
+#include "math/clip_space.h"
+#include "jobs/job_system.h"
 
-// TODO: remove it
+// Camera of the application, with the debug options of the engine for it.
 struct CameraInfo {
     std::shared_ptr<Camera> camera;
 
+    // Draw the viewing frustum of the camera when another camera is active.
     bool show_viewing_frustum = false;
     Color viewing_frustum_color;
 };
@@ -40,13 +48,59 @@ public:
 public:
     std::shared_ptr<World> GetWorld() const;
 
+    // Statistics of the last Draw.
+    const PipelineStatistics &GetPipelineStatistics() const;
+
 public:
     Settings *AccessSettings();
 
     void SetDefaultSettings();
 
+public:
+    /**
+     * Sets the job system the geometry is processed with. If none is set before Initialize,
+     * a job system with a thread per hardware thread is created.
+     */
+    void SetJobSystem(const std::shared_ptr<jobs::JobSystem> &job_system);
+
+    std::shared_ptr<jobs::JobSystem> GetJobSystem() const;
+
+public:
+    /**
+     * Sets the cameras whose viewing frustums can be drawn, for debugging what another camera sees.
+     * The map is read on every Draw, so the options can be changed after it's set.
+     *
+     * @param cameras Cameras by name, or nullptr to draw no frustums. The caller owns the map, which must stay
+     *                valid while the engine draws.
+     */
+    void SetDebugCameras(const std::unordered_map<std::string, CameraInfo> *cameras);
+
 private:
-    void UpdateRotationVelocities(float ts);
+    // Tests the face against the camera position in the object space.
+    static bool IsFaceCulled(const Mesh::FacePlane &plane, const Vector3 &camera_position, CullMode cull_mode);
+
+    // Conservative test of all the faces of the cluster at once. Faces of clusters that pass it may still be culled.
+    static bool IsClusterCulled(const Mesh::FaceCluster &cluster, const Vector3 &camera_position, CullMode cull_mode);
+
+    /**
+     * Culls the face clusters of the mesh in the object space, and marks the vertex blocks used by the remaining ones.
+     * It's done before any vertex is transformed, so the vertices used only by culled clusters are not transformed.
+     */
+    void CullClusters(const Mesh &mesh, const Vector3 &camera_position);
+
+    // Transforms the vertices of the used blocks to clip space once and computes their outcodes if requested.
+    void TransformVertices(const Mesh &mesh, const Matrix4 &model_view_projection, bool compute_outcodes);
+
+private:
+    // Number of vertices transformed and faces processed by a single job.
+    static constexpr size_t kVerticesBatchSize = 4096;
+    static constexpr size_t kFacesBatchSize = 1024;
+
+    // Number of face clusters culled by a single job.
+    static constexpr size_t kClustersBatchSize = 64;
+
+    static_assert(kVerticesBatchSize % Mesh::kVertexBlockSize == 0, "Batches must consist of whole vertex blocks");
+    static_assert(kFacesBatchSize % Mesh::kClusterSize == 0, "Batches must consist of whole face clusters");
 
 private:
     Matrix4 screen_space_matrix_;
@@ -56,11 +110,39 @@ private:
 
     std::shared_ptr<render::Renderer> renderer_;
 
+    std::unique_ptr<render::Renderer2D> renderer_2d_;
+
     std::unique_ptr<View> view_;
 
+    std::shared_ptr<jobs::JobSystem> job_system_;
+
+private:
+    // Objects found by the frustum query of the frame.
+    std::vector<World::FrustumQueryResult> visible_objects_;
+
+    // Clip space positions and outcodes of the vertices of the object being drawn.
+    // Reused between the objects and the frames.
+    std::vector<Vector4> clip_space_vertices_;
+    std::vector<clip_space::Outcode> vertex_outcodes_;
+
+    // Whether every face cluster of the object being drawn passed the culling, and whether every block of its
+    // vertices is used by such a cluster. The blocks are marked by multiple threads.
+    std::vector<uint8_t> visible_clusters_;
+    std::vector<std::atomic<uint8_t>> used_vertex_blocks_;
+
+    // Primitives of every batch of faces. They are submitted in the order of the batches,
+    // so the output doesn't depend on the number of threads.
+    std::vector<render::PrimitiveBatch> face_batches_;
+    std::vector<PipelineStatistics> face_batch_statistics_;
+
+    PipelineStatistics statistics_;
+
 private:
     std::list<std::shared_ptr<Controller>> controllers_;
 
 private:
     Settings settings_;
+
+private:
+    const std::unordered_map<std::string, CameraInfo> *debug_cameras_ = nullptr;
 };
\ No newline at end of file
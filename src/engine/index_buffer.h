@@ -0,0 +1,126 @@
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <vector>
+
+/**
+ * Contiguous buffer of triangle vertex indices, three per triangle.
+ * Indices are stored as 16-bit values when the vertex count allows, and as 32-bit values otherwise.
+ * The indices may also live in an external storage, e.g. a mapped mesh cache, in which case the buffer is read-only.
+ */
+class IndexBuffer {
+public:
+    enum class Type {
+        kUInt16,
+        kUInt32
+    };
+
+    // Smallest index type that can address the given number of vertices.
+    static Type SelectType(size_t vertices_count) {
+        return vertices_count <= std::numeric_limits<uint16_t>::max() + size_t(1) ? Type::kUInt16 : Type::kUInt32;
+    }
+
+    IndexBuffer() = default;
+
+    explicit IndexBuffer(Type type) : type_(type) {}
+
+    // Takes the 32-bit indices, and narrows them to 16 bits if the vertex count allows.
+    IndexBuffer(std::vector<uint32_t> &&indices, size_t vertices_count) : type_(SelectType(vertices_count)) {
+        if (type_ == Type::kUInt16)
+            indices_16_.assign(indices.begin(), indices.end());
+        else
+            indices_32_ = std::move(indices);
+    }
+
+    /**
+     * Refers to the indices instead of copying them. The storage keeps them alive,
+     * and is shared by the copies of the buffer.
+     */
+    IndexBuffer(Type type, const void *indices, size_t indices_count, std::shared_ptr<const void> storage)
+            : type_(type), external_indices_(indices), external_indices_count_(indices_count),
+              storage_(std::move(storage)) {}
+
+    void Reserve(size_t triangles_count) {
+        assert(!external_indices_ && "External indices are read-only");
+
+        if (type_ == Type::kUInt16)
+            indices_16_.reserve(triangles_count * 3);
+        else
+            indices_32_.reserve(triangles_count * 3);
+    }
+
+    void AddTriangle(uint32_t i1, uint32_t i2, uint32_t i3) {
+        assert(!external_indices_ && "External indices are read-only");
+
+        if (type_ == Type::kUInt16) {
+            assert(i1 <= std::numeric_limits<uint16_t>::max() &&
+                   i2 <= std::numeric_limits<uint16_t>::max() &&
+                   i3 <= std::numeric_limits<uint16_t>::max() && "Index doesn't fit in 16 bits");
+
+            indices_16_.push_back(static_cast<uint16_t>(i1));
+            indices_16_.push_back(static_cast<uint16_t>(i2));
+            indices_16_.push_back(static_cast<uint16_t>(i3));
+        } else {
+            indices_32_.push_back(i1);
+            indices_32_.push_back(i2);
+            indices_32_.push_back(i3);
+        }
+    }
+
+    Type GetType() const {
+        return type_;
+    }
+
+    size_t GetIndicesCount() const {
+        if (external_indices_)
+            return external_indices_count_;
+
+        return type_ == Type::kUInt16 ? indices_16_.size() : indices_32_.size();
+    }
+
+    size_t GetTrianglesCount() const {
+        return GetIndicesCount() / 3;
+    }
+
+    uint32_t operator[](size_t index) const {
+        return type_ == Type::kUInt16 ? GetIndices16()[index] : GetIndices32()[index];
+    }
+
+    /**
+     * Calls the function with a pointer to the indices in their stored type, so the loops over them
+     * can be compiled once per index type instead of branching per index.
+     *
+     * @param function Called as function(const uint16_t *indices, size_t triangles_count) or
+     *                 function(const uint32_t *indices, size_t triangles_count).
+     */
+    template<typename Function>
+    void Visit(Function function) const {
+        if (type_ == Type::kUInt16)
+            function(GetIndices16(), GetTrianglesCount());
+        else
+            function(GetIndices32(), GetTrianglesCount());
+    }
+
+private:
+    const uint16_t *GetIndices16() const {
+        return external_indices_ ? static_cast<const uint16_t *>(external_indices_) : indices_16_.data();
+    }
+
+    const uint32_t *GetIndices32() const {
+        return external_indices_ ? static_cast<const uint32_t *>(external_indices_) : indices_32_.data();
+    }
+
+private:
+    Type type_ = Type::kUInt16;
+
+    std::vector<uint16_t> indices_16_;
+    std::vector<uint32_t> indices_32_;
+
+    const void *external_indices_ = nullptr;
+    size_t external_indices_count_ = 0;
+    std::shared_ptr<const void> storage_;
+};
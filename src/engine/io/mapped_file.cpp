@@ -0,0 +1,186 @@
+#include <algorithm>
+#include <utility>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "mapped_file.h"
+
+using io::MappedFile;
+
+MappedFile::~MappedFile() {
+    Close();
+}
+
+MappedFile::MappedFile(MappedFile &&other) noexcept {
+    *this = std::move(other);
+}
+
+MappedFile &MappedFile::operator=(MappedFile &&other) noexcept {
+    if (this == &other)
+        return *this;
+
+    Close();
+
+    data_ = std::exchange(other.data_, nullptr);
+    size_ = std::exchange(other.size_, 0);
+    open_ = std::exchange(other.open_, false);
+
+#ifdef _WIN32
+    file_ = std::exchange(other.file_, nullptr);
+    mapping_ = std::exchange(other.mapping_, nullptr);
+#endif
+
+    return *this;
+}
+
+#ifdef _WIN32
+
+bool MappedFile::Open(const std::string &path, AccessPattern pattern) {
+    Close();
+
+    DWORD flags = FILE_ATTRIBUTE_NORMAL;
+    if (pattern == AccessPattern::kSequential)
+        flags |= FILE_FLAG_SEQUENTIAL_SCAN;
+    else if (pattern == AccessPattern::kRandom)
+        flags |= FILE_FLAG_RANDOM_ACCESS;
+
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, flags, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+        return false;
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size)) {
+        CloseHandle(file);
+        return false;
+    }
+
+    file_ = file;
+    size_ = static_cast<size_t>(size.QuadPart);
+    open_ = true;
+
+    if (size_ == 0)
+        return true; // Empty files can't be mapped.
+
+    mapping_ = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping_)
+        data_ = static_cast<const char *>(MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0));
+
+    if (!data_) {
+        Close();
+        return false;
+    }
+
+    return true;
+}
+
+void MappedFile::Close() {
+    if (data_)
+        UnmapViewOfFile(data_);
+
+    if (mapping_)
+        CloseHandle(mapping_);
+
+    if (file_)
+        CloseHandle(file_);
+
+    data_ = nullptr;
+    mapping_ = nullptr;
+    file_ = nullptr;
+    size_ = 0;
+    open_ = false;
+}
+
+void MappedFile::Discard(size_t offset, size_t size) {
+    // The pages of a read-only file view are dropped by the system under memory pressure anyway.
+    (void) offset;
+    (void) size;
+}
+
+#else
+
+bool MappedFile::Open(const std::string &path, AccessPattern pattern) {
+    Close();
+
+    const int file = open(path.c_str(), O_RDONLY);
+    if (file < 0)
+        return false;
+
+    struct stat status {};
+    if (fstat(file, &status) != 0) {
+        close(file);
+        return false;
+    }
+
+    size_ = static_cast<size_t>(status.st_size);
+    open_ = true;
+
+    if (size_ == 0) {
+        close(file);
+        return true; // Empty files can't be mapped.
+    }
+
+    void *data = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, file, 0);
+
+    // The mapping keeps the file referenced.
+    close(file);
+
+    if (data == MAP_FAILED) {
+        Close();
+        return false;
+    }
+
+    data_ = static_cast<const char *>(data);
+
+    const int advice = pattern == AccessPattern::kSequential ? MADV_SEQUENTIAL :
+                       pattern == AccessPattern::kRandom ? MADV_RANDOM : MADV_NORMAL;
+    madvise(data, size_, advice);
+
+    return true;
+}
+
+void MappedFile::Close() {
+    if (data_)
+        munmap(const_cast<char *>(data_), size_);
+
+    data_ = nullptr;
+    size_ = 0;
+    open_ = false;
+}
+
+void MappedFile::Discard(size_t offset, size_t size) {
+    if (!data_ || offset >= size_)
+        return;
+
+    size = std::min(size, size_ - offset);
+
+    // Only whole pages inside the range can be dropped.
+    const auto page_size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    const size_t begin = (offset + page_size - 1) / page_size * page_size;
+    const size_t end = (offset + size) / page_size * page_size;
+
+    if (begin < end)
+        madvise(const_cast<char *>(data_) + begin, end - begin, MADV_DONTNEED);
+}
+
+#endif
+
+bool MappedFile::IsOpen() const {
+    return open_;
+}
+
+const char *MappedFile::GetData() const {
+    return data_;
+}
+
+size_t MappedFile::GetSize() const {
+    return size_;
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+namespace io {
+
+    // Read-only memory mapping of a whole file.
+    class MappedFile {
+    public:
+        enum class AccessPattern {
+            kNormal,
+            kSequential,
+            kRandom
+        };
+
+        MappedFile() = default;
+
+        ~MappedFile();
+
+        MappedFile(MappedFile &&other) noexcept;
+
+        MappedFile &operator=(MappedFile &&other) noexcept;
+
+        MappedFile(const MappedFile &) = delete;
+
+        MappedFile &operator=(const MappedFile &) = delete;
+
+        /**
+         * Maps the file, replacing the current mapping.
+         *
+         * @param pattern Hint of how the data will be read, so the system can read ahead or not.
+         * @return False if the file can't be opened or mapped.
+         */
+        bool Open(const std::string &path, AccessPattern pattern = AccessPattern::kSequential);
+
+        void Close();
+
+        bool IsOpen() const;
+
+        // Null for empty files.
+        const char *GetData() const;
+
+        size_t GetSize() const;
+
+        /**
+         * Tells the system the pages in the range won't be read soon, so they can be dropped from memory.
+         * They are read from the file again if they are accessed later.
+         */
+        void Discard(size_t offset, size_t size);
+
+    private:
+        const char *data_ = nullptr;
+        size_t size_ = 0;
+        bool open_ = false;
+
+#ifdef _WIN32
+        void *file_ = nullptr;
+        void *mapping_ = nullptr;
+#endif
+    };
+
+}
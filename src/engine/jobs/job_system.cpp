@@ -0,0 +1,115 @@
+#include <algorithm>
+#include <cassert>
+
+#include "job_system.h"
+
+using jobs::JobSystem;
+
+JobSystem::JobSystem(uint32_t threads_count) {
+    if (threads_count == 0)
+        threads_count = std::max(std::thread::hardware_concurrency(), 1u);
+
+    workers_.reserve(threads_count - 1);
+
+    for (uint32_t i = 1; i < threads_count; i++)
+        workers_.emplace_back([this]() { WorkerLoop(); });
+}
+
+JobSystem::~JobSystem() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+
+    job_available_.notify_all();
+
+    for (std::thread &worker : workers_)
+        worker.join();
+}
+
+uint32_t JobSystem::GetThreadsCount() const {
+    return static_cast<uint32_t>(workers_.size()) + 1;
+}
+
+void JobSystem::ParallelFor(size_t count, size_t batch_size, const RangeFunction &function) {
+    assert(batch_size > 0);
+
+    if (count == 0)
+        return;
+
+    const size_t batches_count = (count + batch_size - 1) / batch_size;
+
+    if (workers_.empty() || batches_count == 1) {
+        for (size_t begin = 0; begin < count; begin += batch_size)
+            function(begin, std::min(begin + batch_size, count));
+        return;
+    }
+
+    Job job;
+    job.function = &function;
+    job.count = count;
+    job.batch_size = batch_size;
+    job.batches_count = batches_count;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        assert(job_ == nullptr && "ParallelFor can't be nested");
+
+        job_ = &job;
+        job_generation_++;
+    }
+
+    job_available_.notify_all();
+
+    RunBatches(&job);
+
+    // The job lives on this stack, so wait for the workers to leave it too, not only for its batches.
+    std::unique_lock<std::mutex> lock(mutex_);
+    job_finished_.wait(lock, [&]() {
+        return job.finished_batches.load() == batches_count && job.active_workers == 0;
+    });
+
+    job_ = nullptr;
+}
+
+void JobSystem::RunBatches(Job *job) {
+    while (true) {
+        const size_t batch = job->next_batch.fetch_add(1);
+        if (batch >= job->batches_count)
+            return;
+
+        const size_t begin = batch * job->batch_size;
+        const size_t end = std::min(begin + job->batch_size, job->count);
+
+        (*job->function)(begin, end);
+
+        job->finished_batches.fetch_add(1);
+    }
+}
+
+void JobSystem::WorkerLoop() {
+    uint64_t seen_generation = 0;
+
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    while (true) {
+        job_available_.wait(lock, [&]() {
+            return stopping_ || (job_ != nullptr && job_generation_ != seen_generation);
+        });
+
+        if (stopping_)
+            return;
+
+        seen_generation = job_generation_;
+
+        Job *job = job_;
+        job->active_workers++;
+
+        lock.unlock();
+        RunBatches(job);
+        lock.lock();
+
+        job->active_workers--;
+        job_finished_.notify_all();
+    }
+}
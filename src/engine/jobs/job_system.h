@@ -0,0 +1,75 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace jobs {
+
+    /**
+     * Pool of worker threads that run data-parallel loops.
+     * The thread that calls ParallelFor takes part in the work, so a job system with one thread has no workers
+     * and runs everything inline.
+     */
+    class JobSystem {
+    public:
+        using RangeFunction = std::function<void(size_t begin, size_t end)>;
+
+        /**
+         * @param threads_count Number of threads the work is spread across, including the calling thread.
+         *                      Zero means the number of hardware threads.
+         */
+        explicit JobSystem(uint32_t threads_count = 0);
+
+        ~JobSystem();
+
+        JobSystem(const JobSystem &) = delete;
+
+        JobSystem &operator=(const JobSystem &) = delete;
+
+        uint32_t GetThreadsCount() const;
+
+        /**
+         * Calls the function for the consecutive ranges [begin, end) of at most batch_size items that cover
+         * [0, count), and returns once all of them are done. The ranges depend only on the count and the batch size,
+         * never on the number of threads, so the results written per range are deterministic.
+         * Must not be called from inside a job.
+         */
+        void ParallelFor(size_t count, size_t batch_size, const RangeFunction &function);
+
+    private:
+        struct Job {
+            const RangeFunction *function;
+            size_t count;
+            size_t batch_size;
+            size_t batches_count;
+
+            std::atomic<size_t> next_batch{0};
+            std::atomic<size_t> finished_batches{0};
+
+            // Workers that are running batches of the job. Guarded by the mutex.
+            uint32_t active_workers = 0;
+        };
+
+        static void RunBatches(Job *job);
+
+        void WorkerLoop();
+
+    private:
+        std::vector<std::thread> workers_;
+
+        std::mutex mutex_;
+        std::condition_variable job_available_;
+        std::condition_variable job_finished_;
+
+        Job *job_ = nullptr;
+        uint64_t job_generation_ = 0;
+        bool stopping_ = false;
+    };
+
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include "vector.h"
+
+// Axis-aligned bounding box.
+struct BoundingBox {
+    Vector3 min;
+    Vector3 max;
+
+    Vector3 GetCenter() const {
+        return (min + max) / 2;
+    }
+
+    Vector3 GetHalfExtents() const {
+        return (max - min) / 2;
+    }
+};
+
+struct BoundingSphere {
+    Vector3 center;
+    float radius;
+};
@@ -0,0 +1,123 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Convex polygon with inline storage, clipped with the Sutherland–Hodgman algorithm.
+ * Clipping by a plane adds at most one point, so a triangle clipped by the six frustum planes
+ * never has more than nine points.
+ *
+ * @tparam Point Point type. It must support addition, subtraction and multiplication by a scalar.
+ */
+template<typename Point, size_t Capacity = 9>
+class ClipPolygon {
+public:
+    static constexpr size_t kCapacity = Capacity;
+
+    ClipPolygon() = default;
+
+    ClipPolygon(const Point &p1, const Point &p2, const Point &p3) : points_{p1, p2, p3}, points_count_(3) {}
+
+    /**
+     * Removes the part of the polygon that lies outside of a plane.
+     *
+     * @param distance Signed distance function of the plane. The points with non-negative distance are inside.
+     *                 If the clipped polygon doesn't fit into the capacity (e.g. the distances aren't those of a plane),
+     *                 the polygon is dropped.
+     */
+    template<typename DistanceFunction>
+    void Clip(DistanceFunction distance) {
+        if (points_count_ == 0)
+            return;
+
+        float distances[Capacity];
+        bool all_inside = true;
+
+        for (uint32_t i = 0; i < points_count_; i++) {
+            distances[i] = distance(points_[i]);
+            all_inside &= distances[i] >= 0;
+        }
+
+        if (all_inside)
+            return;
+
+        Point clipped[Capacity];
+        uint32_t clipped_count = 0;
+
+        for (uint32_t i = 0; i < points_count_; i++) {
+            const uint32_t next = i + 1 == points_count_ ? 0 : i + 1;
+
+            const Point &current_point = points_[i];
+            const Point &next_point = points_[next];
+
+            const float current_distance = distances[i];
+            const float next_distance = distances[next];
+
+            const bool current_inside = current_distance >= 0;
+            const bool next_inside = next_distance >= 0;
+
+            if (current_inside) {
+                if (clipped_count == Capacity) {
+                    points_count_ = 0;
+                    return;
+                }
+
+                clipped[clipped_count++] = current_point;
+            }
+
+            if (current_inside != next_inside) {
+                if (clipped_count == Capacity) {
+                    points_count_ = 0;
+                    return;
+                }
+
+                // Always interpolate from the inside point, so an edge shared by two polygons
+                // is split at exactly the same point.
+                if (current_inside)
+                    clipped[clipped_count++] = Interpolate(current_point, next_point,
+                                                           current_distance / (current_distance - next_distance));
+                else
+                    clipped[clipped_count++] = Interpolate(next_point, current_point,
+                                                           next_distance / (next_distance - current_distance));
+            }
+        }
+
+        for (uint32_t i = 0; i < clipped_count; i++)
+            points_[i] = clipped[i];
+
+        points_count_ = clipped_count;
+    }
+
+    bool IsEmpty() const {
+        return points_count_ < 3;
+    }
+
+    uint32_t GetPointsCount() const {
+        return points_count_;
+    }
+
+    const Point &operator[](size_t index) const {
+        return points_[index];
+    }
+
+    uint32_t GetTrianglesCount() const {
+        return points_count_ < 3 ? 0 : points_count_ - 2;
+    }
+
+    // Triangulates the polygon as a fan around its first point.
+    template<typename Function>
+    void ForEachTriangle(Function function) const {
+        for (uint32_t i = 1; i + 1 < points_count_; i++)
+            function(points_[0], points_[i], points_[i + 1]);
+    }
+
+private:
+    static Point Interpolate(const Point &from, const Point &to, float t) {
+        return from + (to - from) * t;
+    }
+
+private:
+    Point points_[Capacity];
+    uint32_t points_count_ = 0;
+};
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstdint>
+
+#include "vector.h"
+
+// Canonical view volume in homogeneous clip space: -w <= x <= w, -w <= y <= w, 0 <= z <= w.
+namespace clip_space {
+
+    enum PlaneType {
+        kLeftPlane,
+        kRightPlane,
+        kBottomPlane,
+        kTopPlane,
+        kNearPlane,
+        kFarPlane,
+
+        kPlanesCount
+    };
+
+    // Bit mask with a bit set for every plane the point is outside of.
+    using Outcode = uint32_t;
+
+    constexpr Outcode kInside = 0;
+
+    /**
+     * Returns a value proportional to the signed distance from the plane to the point.
+     * It's non-negative for the points inside the view volume.
+     */
+    inline float Distance(const Vector4 &point, PlaneType plane) {
+        switch (plane) {
+            case kLeftPlane:
+                return point.w + point.x;
+            case kRightPlane:
+                return point.w - point.x;
+            case kBottomPlane:
+                return point.w + point.y;
+            case kTopPlane:
+                return point.w - point.y;
+            case kNearPlane:
+                return point.z;
+            case kFarPlane:
+                return point.w - point.z;
+            default:
+                return 0;
+        }
+    }
+
+    inline Outcode ComputeOutcode(const Vector4 &point) {
+        Outcode outcode = kInside;
+
+        outcode |= (point.w + point.x < 0) << kLeftPlane;
+        outcode |= (point.w - point.x < 0) << kRightPlane;
+        outcode |= (point.w + point.y < 0) << kBottomPlane;
+        outcode |= (point.w - point.y < 0) << kTopPlane;
+        outcode |= (point.z < 0) << kNearPlane;
+        outcode |= (point.w - point.z < 0) << kFarPlane;
+
+        return outcode;
+    }
+
+}
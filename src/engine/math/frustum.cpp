@@ -1,4 +1,5 @@
 #include <cassert>
+#include <cmath>
 
 #include "frustum.h"
 
@@ -38,6 +39,48 @@ void Frustum::SetFromModelViewProjection(const Matrix4 &model_view_projection) {
     }
 }
 
+Frustum::Containment Frustum::Contains(const BoundingSphere &sphere) const {
+    Containment containment = Containment::kInside;
+
+    for (const Plane &plane : planes_) {
+        const float distance = plane.DistanceTo(sphere.center);
+
+        if (distance > sphere.radius)
+            return Containment::kOutside;
+
+        if (distance > -sphere.radius)
+            containment = Containment::kIntersecting;
+    }
+
+    return containment;
+}
+
+Frustum::Containment Frustum::Contains(const BoundingBox &box) const {
+    const Vector3 center = box.GetCenter();
+    const Vector3 half_extents = box.GetHalfExtents();
+
+    Containment containment = Containment::kInside;
+
+    for (const Plane &plane : planes_) {
+        const Vector3 &normal = plane.GetNormal();
+
+        // Projection of the half extents onto the normal.
+        const float radius = std::abs(normal.x) * half_extents.x +
+                             std::abs(normal.y) * half_extents.y +
+                             std::abs(normal.z) * half_extents.z;
+
+        const float distance = plane.DistanceTo(center);
+
+        if (distance > radius)
+            return Containment::kOutside;
+
+        if (distance > -radius)
+            containment = Containment::kIntersecting;
+    }
+
+    return containment;
+}
+
 std::array<Vector3, Frustum::kCornersCount> Frustum::ComputeCornerPoints() const {
     std::array<Vector3, kCornersCount> corner_points;
 
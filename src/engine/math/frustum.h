@@ -2,6 +2,7 @@
 
 #include <array>
 
+#include "bounding_volumes.h"
 #include "plane.h"
 #include "matrix.h"
 
@@ -31,8 +32,20 @@ public:
         kCornersCount
     };
 
+    enum class Containment {
+        kOutside,
+        kIntersecting,
+        kInside
+    };
+
     void SetFromModelViewProjection(const Matrix4 &model_view_projection);
 
+    // The tests are conservative: volumes near the frustum edges may be reported as intersecting it.
+    // They expect the plane normals to point out of the frustum, as set from the matrix.
+    Containment Contains(const BoundingSphere &sphere) const;
+
+    Containment Contains(const BoundingBox &box) const;
+
     std::array<Vector3, kCornersCount> ComputeCornerPoints() const;
 
     void Invert();
@@ -61,4 +61,41 @@ Matrix4 matrix::Scale(float scale) {
             {0,     0,     scale, 0},
             {0,     0,     0,     1}
     };
-}
\ No newline at end of file
+}
+
+Matrix4 matrix::InvertRigid(const Matrix4 &transform) {
+    // The inverse of [R | t] is [R^T | -R^T * t].
+    const Vector3 translation = transform.GetColumn<3>(3);
+
+    Matrix4 res;
+    res.SetZero();
+
+    for (size_t row = 0; row < 3; row++) {
+        const Vector3 column = transform.GetColumn<3>(row);
+        res.SetRow(row, column);
+        res[row][3] = -column.Dot(translation);
+    }
+
+    res[3][3] = 1;
+
+    return res;
+}
+
+Vector3 matrix::TransformNormal(const Matrix4 &transform, const Vector3 &normal) {
+    const Vector3 column0 = transform.GetColumn<3>(0);
+    const Vector3 column1 = transform.GetColumn<3>(1);
+    const Vector3 column2 = transform.GetColumn<3>(2);
+
+    // The columns of the cofactor matrix, which is the inverse transpose scaled by the determinant.
+    const Vector3 cofactor0 = column1.Cross(column2);
+    const Vector3 cofactor1 = column2.Cross(column0);
+    const Vector3 cofactor2 = column0.Cross(column1);
+
+    Vector3 result = cofactor0 * normal[0] + cofactor1 * normal[1] + cofactor2 * normal[2];
+
+    // A negative determinant mirrors the space, which flips the cofactor matrix.
+    if (column0.Dot(cofactor0) < 0)
+        result = result * -1.f;
+
+    return result.Normalize();
+}
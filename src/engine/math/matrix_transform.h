@@ -17,4 +17,10 @@ namespace matrix {
 
     Matrix4 Scale(float scale);
 
+    // Inverts a transform that is composed of rotations and translations only.
+    Matrix4 InvertRigid(const Matrix4 &transform);
+
+    // Transforms a normal by the inverse transpose of the linear part of the transform, and normalizes it.
+    Vector3 TransformNormal(const Matrix4 &transform, const Vector3 &normal);
+
 }
\ No newline at end of file
@@ -0,0 +1,155 @@
+#include "simd.h"
+
+// This file is compiled with AVX2 and FMA code generation enabled, see CMakeLists.txt.
+// It must not call inline functions from the headers: the linker could pick their AVX2 copies for the whole program.
+#if defined(__AVX2__)
+
+#include <immintrin.h>
+
+static void MultiplyMatrices(const Matrix4 &lhs, const Matrix4 &rhs, Matrix4 *result) {
+    // Two rows of the result are computed at once, one per 128-bit lane.
+    const __m256 r0 = _mm256_broadcast_ps(reinterpret_cast<const __m128 *>(rhs.values[0]));
+    const __m256 r1 = _mm256_broadcast_ps(reinterpret_cast<const __m128 *>(rhs.values[1]));
+    const __m256 r2 = _mm256_broadcast_ps(reinterpret_cast<const __m128 *>(rhs.values[2]));
+    const __m256 r3 = _mm256_broadcast_ps(reinterpret_cast<const __m128 *>(rhs.values[3]));
+
+    for (size_t row = 0; row < 4; row += 2) {
+        const float *l0 = lhs.values[row];
+        const float *l1 = lhs.values[row + 1];
+
+        __m256 res = _mm256_mul_ps(_mm256_setr_m128(_mm_set1_ps(l0[0]), _mm_set1_ps(l1[0])), r0);
+        res = _mm256_fmadd_ps(_mm256_setr_m128(_mm_set1_ps(l0[1]), _mm_set1_ps(l1[1])), r1, res);
+        res = _mm256_fmadd_ps(_mm256_setr_m128(_mm_set1_ps(l0[2]), _mm_set1_ps(l1[2])), r2, res);
+        res = _mm256_fmadd_ps(_mm256_setr_m128(_mm_set1_ps(l0[3]), _mm_set1_ps(l1[3])), r3, res);
+
+        _mm256_storeu_ps(result->values[row], res);
+    }
+}
+
+static void TransformVector(const Matrix4 &matrix, const Vector4 &vector, Vector4 *result) {
+    const __m128 v = _mm_loadu_ps(vector.values);
+
+    // Dot products of the rows with the vector.
+    const __m256 rows01 = _mm256_mul_ps(_mm256_loadu_ps(matrix.values[0]), _mm256_setr_m128(v, v));
+    const __m256 rows23 = _mm256_mul_ps(_mm256_loadu_ps(matrix.values[2]), _mm256_setr_m128(v, v));
+
+    const __m256 sums = _mm256_hadd_ps(_mm256_hadd_ps(rows01, rows23), _mm256_setzero_ps());
+
+    // sums = {r0, r2, 0, 0 | r1, r3, 0, 0}
+    const __m128 low = _mm256_castps256_ps128(sums);
+    const __m128 high = _mm256_extractf128_ps(sums, 1);
+
+    _mm_storeu_ps(result->values, _mm_unpacklo_ps(low, high));
+}
+
+// Transposes eight transformed points from structure of arrays back to an array of Vector4.
+static void StoreTransposed(const __m256 components[4], float *destination) {
+    const __m256 t0 = _mm256_unpacklo_ps(components[0], components[1]);
+    const __m256 t1 = _mm256_unpackhi_ps(components[0], components[1]);
+    const __m256 t2 = _mm256_unpacklo_ps(components[2], components[3]);
+    const __m256 t3 = _mm256_unpackhi_ps(components[2], components[3]);
+
+    const __m256 p04 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0));
+    const __m256 p15 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2));
+    const __m256 p26 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0));
+    const __m256 p37 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(3, 2, 3, 2));
+
+    _mm256_storeu_ps(destination + 0, _mm256_permute2f128_ps(p04, p15, 0x20));
+    _mm256_storeu_ps(destination + 8, _mm256_permute2f128_ps(p26, p37, 0x20));
+    _mm256_storeu_ps(destination + 16, _mm256_permute2f128_ps(p04, p15, 0x31));
+    _mm256_storeu_ps(destination + 24, _mm256_permute2f128_ps(p26, p37, 0x31));
+}
+
+// Transforms eight points given as structure of arrays.
+static void Transform8(const float *m, __m256 x, __m256 y, __m256 z, __m256 components[4]) {
+    for (size_t row = 0; row < 4; row++) {
+        const float *r = m + row * 4;
+
+        __m256 value = _mm256_fmadd_ps(_mm256_set1_ps(r[0]), x, _mm256_set1_ps(r[3]));
+        value = _mm256_fmadd_ps(_mm256_set1_ps(r[1]), y, value);
+        components[row] = _mm256_fmadd_ps(_mm256_set1_ps(r[2]), z, value);
+    }
+}
+
+// Transforms a single point.
+static __m128 Transform1(const float *m, float x, float y, float z) {
+    const __m128 c0 = _mm_setr_ps(m[0], m[4], m[8], m[12]);
+    const __m128 c1 = _mm_setr_ps(m[1], m[5], m[9], m[13]);
+    const __m128 c2 = _mm_setr_ps(m[2], m[6], m[10], m[14]);
+    const __m128 c3 = _mm_setr_ps(m[3], m[7], m[11], m[15]);
+
+    __m128 value = _mm_fmadd_ps(c0, _mm_set1_ps(x), c3);
+    value = _mm_fmadd_ps(c1, _mm_set1_ps(y), value);
+    return _mm_fmadd_ps(c2, _mm_set1_ps(z), value);
+}
+
+static void TransformPoints(const Matrix4 &matrix, const Vector3 *points, size_t stride,
+                            Vector4 *result, size_t count) {
+    const float *m = matrix.values[0];
+
+    const __m256i offsets = _mm256_mullo_epi32(_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7),
+                                               _mm256_set1_epi32(static_cast<int>(stride / sizeof(float))));
+
+    const auto *bytes = reinterpret_cast<const char *>(points);
+
+    size_t i = 0;
+
+    // Eight points at a time, as structure of arrays.
+    for (; i + 8 <= count; i += 8) {
+        const auto *first = reinterpret_cast<const float *>(bytes + i * stride);
+
+        const __m256 x = _mm256_i32gather_ps(first + 0, offsets, sizeof(float));
+        const __m256 y = _mm256_i32gather_ps(first + 1, offsets, sizeof(float));
+        const __m256 z = _mm256_i32gather_ps(first + 2, offsets, sizeof(float));
+
+        __m256 components[4];
+        Transform8(m, x, y, z, components);
+
+        StoreTransposed(components, result[i].values);
+    }
+
+    // Remaining points, one at a time.
+    for (; i < count; i++) {
+        const auto *point = reinterpret_cast<const float *>(bytes + i * stride);
+        _mm_storeu_ps(result[i].values, Transform1(m, point[0], point[1], point[2]));
+    }
+}
+
+static void TransformPointsSoA(const Matrix4 &matrix, const float *x, const float *y, const float *z,
+                               Vector4 *result, size_t count) {
+    const float *m = matrix.values[0];
+
+    size_t i = 0;
+
+    // Eight points at a time.
+    for (; i + 8 <= count; i += 8) {
+        __m256 components[4];
+        Transform8(m, _mm256_loadu_ps(x + i), _mm256_loadu_ps(y + i), _mm256_loadu_ps(z + i), components);
+
+        StoreTransposed(components, result[i].values);
+    }
+
+    for (; i < count; i++)
+        _mm_storeu_ps(result[i].values, Transform1(m, x[i], y[i], z[i]));
+}
+
+const simd::Kernels *simd::GetAVX2Kernels() {
+    static const Kernels kernels{
+            .instruction_set = InstructionSet::kAVX2,
+            .name = "avx2",
+            .multiply_matrices = MultiplyMatrices,
+            .transform_vector = TransformVector,
+            .transform_points = TransformPoints,
+            .transform_points_soa = TransformPointsSoA
+    };
+
+    return &kernels;
+}
+
+#else
+
+const simd::Kernels *simd::GetAVX2Kernels() {
+    return nullptr;
+}
+
+#endif
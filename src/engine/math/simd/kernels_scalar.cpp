@@ -0,0 +1,46 @@
+#include "simd.h"
+
+static void MultiplyMatrices(const Matrix4 &lhs, const Matrix4 &rhs, Matrix4 *result) {
+    *result = lhs * rhs;
+}
+
+static void TransformVector(const Matrix4 &matrix, const Vector4 &vector, Vector4 *result) {
+    *result = matrix * vector;
+}
+
+static void TransformPoints(const Matrix4 &matrix, const Vector3 *points, size_t stride,
+                            Vector4 *result, size_t count) {
+    const auto *bytes = reinterpret_cast<const char *>(points);
+
+    for (size_t i = 0; i < count; i++) {
+        const auto &point = *reinterpret_cast<const Vector3 *>(bytes + i * stride);
+
+        result[i] = Vector4(matrix[0][0] * point[0] + matrix[0][1] * point[1] + matrix[0][2] * point[2] + matrix[0][3],
+                            matrix[1][0] * point[0] + matrix[1][1] * point[1] + matrix[1][2] * point[2] + matrix[1][3],
+                            matrix[2][0] * point[0] + matrix[2][1] * point[1] + matrix[2][2] * point[2] + matrix[2][3],
+                            matrix[3][0] * point[0] + matrix[3][1] * point[1] + matrix[3][2] * point[2] + matrix[3][3]);
+    }
+}
+
+static void TransformPointsSoA(const Matrix4 &matrix, const float *x, const float *y, const float *z,
+                               Vector4 *result, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        result[i] = Vector4(matrix[0][0] * x[i] + matrix[0][1] * y[i] + matrix[0][2] * z[i] + matrix[0][3],
+                            matrix[1][0] * x[i] + matrix[1][1] * y[i] + matrix[1][2] * z[i] + matrix[1][3],
+                            matrix[2][0] * x[i] + matrix[2][1] * y[i] + matrix[2][2] * z[i] + matrix[2][3],
+                            matrix[3][0] * x[i] + matrix[3][1] * y[i] + matrix[3][2] * z[i] + matrix[3][3]);
+    }
+}
+
+const simd::Kernels *simd::GetScalarKernels() {
+    static const Kernels kernels{
+            .instruction_set = InstructionSet::kScalar,
+            .name = "scalar",
+            .multiply_matrices = MultiplyMatrices,
+            .transform_vector = TransformVector,
+            .transform_points = TransformPoints,
+            .transform_points_soa = TransformPointsSoA
+    };
+
+    return &kernels;
+}
@@ -0,0 +1,129 @@
+#include "simd.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+
+#include <emmintrin.h>
+
+namespace {
+    struct Columns {
+        __m128 c0, c1, c2, c3;
+    };
+
+    inline Columns LoadColumns(const Matrix4 &matrix) {
+        Columns columns{_mm_loadu_ps(matrix[0]),
+                        _mm_loadu_ps(matrix[1]),
+                        _mm_loadu_ps(matrix[2]),
+                        _mm_loadu_ps(matrix[3])};
+
+        _MM_TRANSPOSE4_PS(columns.c0, columns.c1, columns.c2, columns.c3);
+
+        return columns;
+    }
+
+    inline __m128 Transform(const Columns &columns, __m128 x, __m128 y, __m128 z, __m128 w) {
+        return _mm_add_ps(_mm_add_ps(_mm_mul_ps(columns.c0, x), _mm_mul_ps(columns.c1, y)),
+                          _mm_add_ps(_mm_mul_ps(columns.c2, z), _mm_mul_ps(columns.c3, w)));
+    }
+}
+
+static void MultiplyMatrices(const Matrix4 &lhs, const Matrix4 &rhs, Matrix4 *result) {
+    const __m128 r0 = _mm_loadu_ps(rhs[0]);
+    const __m128 r1 = _mm_loadu_ps(rhs[1]);
+    const __m128 r2 = _mm_loadu_ps(rhs[2]);
+    const __m128 r3 = _mm_loadu_ps(rhs[3]);
+
+    // Row i of the result is a linear combination of the rows of rhs.
+    for (size_t row = 0; row < 4; row++) {
+        const float *l = lhs[row];
+
+        const __m128 res = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(l[0]), r0), _mm_mul_ps(_mm_set1_ps(l[1]), r1)),
+                                      _mm_add_ps(_mm_mul_ps(_mm_set1_ps(l[2]), r2), _mm_mul_ps(_mm_set1_ps(l[3]), r3)));
+
+        _mm_storeu_ps((*result)[row], res);
+    }
+}
+
+static void TransformVector(const Matrix4 &matrix, const Vector4 &vector, Vector4 *result) {
+    const Columns columns = LoadColumns(matrix);
+
+    _mm_storeu_ps(&(*result)[0], Transform(columns,
+                                           _mm_set1_ps(vector[0]),
+                                           _mm_set1_ps(vector[1]),
+                                           _mm_set1_ps(vector[2]),
+                                           _mm_set1_ps(vector[3])));
+}
+
+static void TransformPoints(const Matrix4 &matrix, const Vector3 *points, size_t stride,
+                            Vector4 *result, size_t count) {
+    const Columns columns = LoadColumns(matrix);
+    const __m128 one = _mm_set1_ps(1.f);
+
+    const auto *bytes = reinterpret_cast<const char *>(points);
+
+    for (size_t i = 0; i < count; i++) {
+        const auto *point = reinterpret_cast<const float *>(bytes + i * stride);
+
+        _mm_storeu_ps(&result[i][0], Transform(columns,
+                                               _mm_set1_ps(point[0]),
+                                               _mm_set1_ps(point[1]),
+                                               _mm_set1_ps(point[2]),
+                                               one));
+    }
+}
+
+static void TransformPointsSoA(const Matrix4 &matrix, const float *x, const float *y, const float *z,
+                               Vector4 *result, size_t count) {
+    const float *m = matrix[0];
+
+    size_t i = 0;
+
+    // Four points at a time.
+    for (; i + 4 <= count; i += 4) {
+        const __m128 px = _mm_loadu_ps(x + i);
+        const __m128 py = _mm_loadu_ps(y + i);
+        const __m128 pz = _mm_loadu_ps(z + i);
+
+        __m128 out[4];
+
+        for (size_t row = 0; row < 4; row++) {
+            const float *r = m + row * 4;
+
+            out[row] = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(r[0]), px), _mm_mul_ps(_mm_set1_ps(r[1]), py)),
+                                  _mm_add_ps(_mm_mul_ps(_mm_set1_ps(r[2]), pz), _mm_set1_ps(r[3])));
+        }
+
+        _MM_TRANSPOSE4_PS(out[0], out[1], out[2], out[3]);
+
+        _mm_storeu_ps(&result[i + 0][0], out[0]);
+        _mm_storeu_ps(&result[i + 1][0], out[1]);
+        _mm_storeu_ps(&result[i + 2][0], out[2]);
+        _mm_storeu_ps(&result[i + 3][0], out[3]);
+    }
+
+    const Columns columns = LoadColumns(matrix);
+    const __m128 one = _mm_set1_ps(1.f);
+
+    for (; i < count; i++)
+        _mm_storeu_ps(&result[i][0], Transform(columns, _mm_set1_ps(x[i]), _mm_set1_ps(y[i]), _mm_set1_ps(z[i]), one));
+}
+
+const simd::Kernels *simd::GetSSEKernels() {
+    static const Kernels kernels{
+            .instruction_set = InstructionSet::kSSE,
+            .name = "sse",
+            .multiply_matrices = MultiplyMatrices,
+            .transform_vector = TransformVector,
+            .transform_points = TransformPoints,
+            .transform_points_soa = TransformPointsSoA
+    };
+
+    return &kernels;
+}
+
+#else
+
+const simd::Kernels *simd::GetSSEKernels() {
+    return nullptr;
+}
+
+#endif
@@ -0,0 +1,109 @@
+#include <atomic>
+
+#include "simd.h"
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+
+#include <intrin.h>
+
+static bool IsAVX2SupportedByCPU() {
+    int info[4];
+
+    __cpuid(info, 0);
+    if (info[0] < 7)
+        return false;
+
+    __cpuid(info, 1);
+    const bool fma = (info[2] & (1 << 12)) != 0;
+    const bool os_saves_ymm = (info[2] & (1 << 27)) != 0 && (_xgetbv(0) & 0x6) == 0x6;
+
+    __cpuidex(info, 7, 0);
+    const bool avx2 = (info[1] & (1 << 5)) != 0;
+
+    return fma && os_saves_ymm && avx2;
+}
+
+static bool IsSSESupportedByCPU() {
+    return true; // Part of the x86-64 baseline.
+}
+
+#elif (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+
+static bool IsAVX2SupportedByCPU() {
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+}
+
+static bool IsSSESupportedByCPU() {
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("sse2");
+}
+
+#else
+
+static bool IsAVX2SupportedByCPU() {
+    return false;
+}
+
+static bool IsSSESupportedByCPU() {
+    return false;
+}
+
+#endif
+
+const simd::Kernels *simd::GetKernels(InstructionSet instruction_set) {
+    switch (instruction_set) {
+        case InstructionSet::kScalar:
+            return GetScalarKernels();
+        case InstructionSet::kSSE:
+            return GetSSEKernels();
+        case InstructionSet::kAVX2:
+            return GetAVX2Kernels();
+    }
+
+    return nullptr;
+}
+
+bool simd::IsInstructionSetSupported(InstructionSet instruction_set) {
+    if (GetKernels(instruction_set) == nullptr)
+        return false; // Not compiled in.
+
+    switch (instruction_set) {
+        case InstructionSet::kScalar:
+            return true;
+        case InstructionSet::kSSE:
+            return IsSSESupportedByCPU();
+        case InstructionSet::kAVX2:
+            return IsAVX2SupportedByCPU();
+    }
+
+    return false;
+}
+
+static const simd::Kernels *SelectBestKernels() {
+    using simd::InstructionSet;
+
+    for (InstructionSet instruction_set : {InstructionSet::kAVX2, InstructionSet::kSSE}) {
+        if (simd::IsInstructionSetSupported(instruction_set))
+            return simd::GetKernels(instruction_set);
+    }
+
+    return simd::GetScalarKernels();
+}
+
+static std::atomic<const simd::Kernels *> &SelectedKernels() {
+    static std::atomic<const simd::Kernels *> kernels(SelectBestKernels());
+    return kernels;
+}
+
+const simd::Kernels &simd::GetKernels() {
+    return *SelectedKernels().load(std::memory_order_relaxed);
+}
+
+bool simd::SelectInstructionSet(InstructionSet instruction_set) {
+    if (!IsInstructionSetSupported(instruction_set))
+        return false;
+
+    SelectedKernels().store(GetKernels(instruction_set), std::memory_order_relaxed);
+    return true;
+}
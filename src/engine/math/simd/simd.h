@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstddef>
+
+#include "../matrix.h"
+#include "../vector.h"
+
+// Vectorized matrix kernels. The best implementation supported by the CPU is selected at startup.
+namespace simd {
+
+    enum class InstructionSet {
+        kScalar,
+        kSSE,
+        kAVX2
+    };
+
+    struct Kernels {
+        InstructionSet instruction_set;
+        const char *name;
+
+        // result = lhs * rhs
+        void (*multiply_matrices)(const Matrix4 &lhs, const Matrix4 &rhs, Matrix4 *result);
+
+        // result = matrix * vector
+        void (*transform_vector)(const Matrix4 &matrix, const Vector4 &vector, Vector4 *result);
+
+        /**
+         * Transforms a batch of points with W equal to one: result[i] = matrix * (points[i], 1).
+         *
+         * @param points First point. The points don't have to be tightly packed.
+         * @param stride Distance between two consecutive points, in bytes. Must be a multiple of four.
+         */
+        void (*transform_points)(const Matrix4 &matrix, const Vector3 *points, size_t stride,
+                                 Vector4 *result, size_t count);
+
+        // Same as transform_points, but the coordinates of the points are given as separate streams.
+        void (*transform_points_soa)(const Matrix4 &matrix, const float *x, const float *y, const float *z,
+                                     Vector4 *result, size_t count);
+    };
+
+    // Kernels selected for this CPU.
+    const Kernels &GetKernels();
+
+    /**
+     * Overrides the selected kernels.
+     *
+     * @return False if the instruction set is not supported by the CPU or by the build.
+     */
+    bool SelectInstructionSet(InstructionSet instruction_set);
+
+    bool IsInstructionSetSupported(InstructionSet instruction_set);
+
+    // Returns nullptr if the kernels are not compiled in.
+    const Kernels *GetKernels(InstructionSet instruction_set);
+
+    const Kernels *GetScalarKernels();
+
+    const Kernels *GetSSEKernels();
+
+    const Kernels *GetAVX2Kernels();
+
+}
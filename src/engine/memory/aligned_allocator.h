@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstddef>
+#include <new>
+#include <vector>
+
+namespace memory {
+
+    // Allocator that aligns the storage to the given boundary, e.g. the width of a SIMD register.
+    template<typename T, size_t Alignment>
+    class AlignedAllocator {
+    public:
+        using value_type = T;
+
+        template<typename U>
+        struct rebind {
+            using other = AlignedAllocator<U, Alignment>;
+        };
+
+        AlignedAllocator() = default;
+
+        template<typename U>
+        AlignedAllocator(const AlignedAllocator<U, Alignment> &) {}
+
+        T *allocate(size_t count) {
+            return static_cast<T *>(::operator new(count * sizeof(T), std::align_val_t(Alignment)));
+        }
+
+        void deallocate(T *pointer, size_t) {
+            ::operator delete(pointer, std::align_val_t(Alignment));
+        }
+
+        template<typename U>
+        bool operator==(const AlignedAllocator<U, Alignment> &) const {
+            return true;
+        }
+
+        template<typename U>
+        bool operator!=(const AlignedAllocator<U, Alignment> &) const {
+            return false;
+        }
+    };
+
+    // Alignment of an AVX register.
+    constexpr size_t kSimdAlignment = 32;
+
+    template<typename T>
+    using AlignedVector = std::vector<T, AlignedAllocator<T, kSimdAlignment>>;
+
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+namespace memory {
+
+    // Read-only view of contiguous elements it doesn't own, like std::span of C++20.
+    template<typename T>
+    class ArrayView {
+    public:
+        ArrayView() = default;
+
+        ArrayView(const T *data, size_t size) : data_(data), size_(size) {}
+
+        template<typename Allocator>
+        ArrayView(const std::vector<T, Allocator> &elements) : data_(elements.data()), size_(elements.size()) {}
+
+        const T *data() const {
+            return data_;
+        }
+
+        size_t size() const {
+            return size_;
+        }
+
+        bool empty() const {
+            return size_ == 0;
+        }
+
+        const T *begin() const {
+            return data_;
+        }
+
+        const T *end() const {
+            return data_ + size_;
+        }
+
+        const T &operator[](size_t index) const {
+            return data_[index];
+        }
+
+    private:
+        const T *data_ = nullptr;
+        size_t size_ = 0;
+    };
+
+}
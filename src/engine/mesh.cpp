@@ -1,22 +1,369 @@
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
 #include "mesh.h"
+#include "math/matrix_transform.h"
 
 void Mesh::SetVertices(std::vector<Vertex> &&vertices) {
+    CopyExternalArrays();
+
     vertices_ = std::move(vertices);
+    UpdateBounds();
+    UpdateFacePlanes();
+    UpdateFaceClusters();
+    UpdateVertexStreams();
 }
 
-void Mesh::SetFaces(std::vector<Face> &&faces) {
-    faces_ = std::move(faces);
+void Mesh::SetIndices(IndexBuffer &&indices) {
+    CopyExternalArrays();
+
+    indices_ = std::move(indices);
+    UpdateFacePlanes();
+    UpdateFaceClusters();
 }
 
 void Mesh::Transform(const Matrix4 &transform) {
+    CopyExternalArrays();
+
     for (Vertex &vertex : vertices_)
         vertex.position = transform * vertex.position;
+
+    for (Vector3 &normal : normals_)
+        normal = matrix::TransformNormal(transform, normal);
+
+    UpdateBounds();
+    UpdateFacePlanes();
+    UpdateFaceClusters();
+    UpdateVertexStreams();
+}
+
+memory::ArrayView<Mesh::Vertex> Mesh::GetVertices() const {
+    return storage_ ? external_arrays_.vertices : memory::ArrayView<Vertex>(vertices_);
+}
+
+const IndexBuffer &Mesh::GetIndices() const {
+    return indices_;
+}
+
+size_t Mesh::GetFacesCount() const {
+    return indices_.GetTrianglesCount();
+}
+
+const Mesh::Bounds &Mesh::GetBounds() const {
+    return bounds_;
+}
+
+memory::ArrayView<Mesh::FacePlane> Mesh::GetFacePlanes() const {
+    return storage_ ? external_arrays_.face_planes : memory::ArrayView<FacePlane>(face_planes_);
+}
+
+memory::ArrayView<Mesh::FaceCluster> Mesh::GetFaceClusters() const {
+    return storage_ ? external_arrays_.face_clusters : memory::ArrayView<FaceCluster>(face_clusters_);
+}
+
+memory::ArrayView<uint32_t> Mesh::GetClusterVertexBlocks() const {
+    return storage_ ? external_arrays_.cluster_vertex_blocks : memory::ArrayView<uint32_t>(cluster_vertex_blocks_);
+}
+
+void Mesh::SetNormals(std::vector<Vector3> &&normals, IndexBuffer &&normal_indices) {
+    assert(normal_indices.GetIndicesCount() == indices_.GetIndicesCount() && "Every face corner must have a normal");
+
+    CopyExternalArrays();
+
+    normals_ = std::move(normals);
+    normal_indices_ = std::move(normal_indices);
+}
+
+void Mesh::SetTextureCoordinates(std::vector<Vector2> &&texture_coordinates,
+                                 IndexBuffer &&texture_coordinate_indices) {
+    assert(texture_coordinate_indices.GetIndicesCount() == indices_.GetIndicesCount() &&
+           "Every face corner must have a texture coordinate");
+
+    CopyExternalArrays();
+
+    texture_coordinates_ = std::move(texture_coordinates);
+    texture_coordinate_indices_ = std::move(texture_coordinate_indices);
+}
+
+bool Mesh::HasNormals() const {
+    return !GetNormals().empty();
+}
+
+memory::ArrayView<Vector3> Mesh::GetNormals() const {
+    return storage_ ? external_arrays_.normals : memory::ArrayView<Vector3>(normals_);
+}
+
+const IndexBuffer &Mesh::GetNormalIndices() const {
+    return normal_indices_;
+}
+
+bool Mesh::HasTextureCoordinates() const {
+    return !GetTextureCoordinates().empty();
+}
+
+memory::ArrayView<Vector2> Mesh::GetTextureCoordinates() const {
+    return storage_ ? external_arrays_.texture_coordinates : memory::ArrayView<Vector2>(texture_coordinates_);
+}
+
+const IndexBuffer &Mesh::GetTextureCoordinateIndices() const {
+    return texture_coordinate_indices_;
+}
+
+void Mesh::ComputeSmoothNormals() {
+    CopyExternalArrays();
+
+    std::vector<Vector3> normals(vertices_.size(), Vector3::Zero());
+
+    indices_.Visit([&](const auto *indices, size_t faces_count) {
+        for (size_t face = 0; face < faces_count; face++, indices += 3) {
+            const Vector3 &p1 = vertices_[indices[0]].position;
+            const Vector3 &p2 = vertices_[indices[1]].position;
+            const Vector3 &p3 = vertices_[indices[2]].position;
+
+            // The length of the cross product is twice the face area.
+            const Vector3 area_normal = (p2 - p1).Cross(p3 - p1);
+
+            for (int corner = 0; corner < 3; corner++)
+                normals[indices[corner]] += area_normal;
+        }
+    });
+
+    for (Vector3 &normal : normals) {
+        const float length = normal.GetLength();
+        if (length > 0)
+            normal /= length;
+    }
+
+    normals_ = std::move(normals);
+    normal_indices_ = indices_;
+}
+
+void Mesh::SetSubMeshes(std::vector<SubMesh> &&sub_meshes) {
+    sub_meshes_ = std::move(sub_meshes);
+}
+
+const std::vector<Mesh::SubMesh> &Mesh::GetSubMeshes() const {
+    return sub_meshes_;
+}
+
+void Mesh::SetExternalArrays(std::shared_ptr<const void> storage, const ExternalArrays &arrays,
+                             const Bounds &bounds) {
+    assert(storage && "External arrays must have a storage");
+    assert(arrays.face_planes.size() == GetFacesCount() && "Every face must have a plane");
+    assert(arrays.face_clusters.size() == (GetFacesCount() + kClusterSize - 1) / kClusterSize &&
+           "Every face must be in a cluster");
+
+    vertices_.clear();
+    face_planes_.clear();
+    face_clusters_.clear();
+    cluster_vertex_blocks_.clear();
+    normals_.clear();
+    texture_coordinates_.clear();
+
+    storage_ = std::move(storage);
+    external_arrays_ = arrays;
+    bounds_ = bounds;
+
+    UpdateVertexStreams();
+}
+
+bool Mesh::HasExternalArrays() const {
+    return storage_ != nullptr;
+}
+
+void Mesh::CopyExternalArrays() {
+    if (!storage_)
+        return;
+
+    const ExternalArrays &arrays = external_arrays_;
+
+    vertices_.assign(arrays.vertices.begin(), arrays.vertices.end());
+    face_planes_.assign(arrays.face_planes.begin(), arrays.face_planes.end());
+    face_clusters_.assign(arrays.face_clusters.begin(), arrays.face_clusters.end());
+    cluster_vertex_blocks_.assign(arrays.cluster_vertex_blocks.begin(), arrays.cluster_vertex_blocks.end());
+    normals_.assign(arrays.normals.begin(), arrays.normals.end());
+    texture_coordinates_.assign(arrays.texture_coordinates.begin(), arrays.texture_coordinates.end());
+
+    // The index buffers keep their own reference to the storage.
+    storage_.reset();
+    external_arrays_ = ExternalArrays();
+}
+
+void Mesh::UpdateBounds() {
+    if (vertices_.empty()) {
+        bounds_ = {};
+        return;
+    }
+
+    BoundingBox &box = bounds_.box;
+    box.min = vertices_[0].position;
+    box.max = box.min;
+
+    for (const Vertex &vertex : vertices_) {
+        for (int axis = 0; axis < 3; axis++) {
+            box.min[axis] = std::min(box.min[axis], vertex.position[axis]);
+            box.max[axis] = std::max(box.max[axis], vertex.position[axis]);
+        }
+    }
+
+    BoundingSphere &sphere = bounds_.sphere;
+    sphere.center = box.GetCenter();
+
+    float radius_squared = 0;
+    for (const Vertex &vertex : vertices_)
+        radius_squared = std::max(radius_squared, (vertex.position - sphere.center).GetLengthSquared());
+
+    sphere.radius = std::sqrt(radius_squared);
+}
+
+void Mesh::UpdateFacePlanes() {
+    // The indices are set after the vertices.
+    if (vertices_.empty()) {
+        face_planes_.clear();
+        return;
+    }
+
+    face_planes_.resize(GetFacesCount());
+
+    indices_.Visit([&](const auto *indices, size_t faces_count) {
+        for (size_t face = 0; face < faces_count; face++, indices += 3) {
+            const Vector3 &p1 = vertices_[indices[0]].position;
+            const Vector3 &p2 = vertices_[indices[1]].position;
+            const Vector3 &p3 = vertices_[indices[2]].position;
+
+            Vector3 normal = (p2 - p1).Cross(p3 - p1);
+
+            const float length = normal.GetLength();
+            normal = length > 0 ? normal / length : Vector3::Zero();
+
+            face_planes_[face] = FacePlane{normal, normal.Dot(p1)};
+        }
+    });
+}
+
+void Mesh::UpdateFaceClusters() {
+    face_clusters_.clear();
+    cluster_vertex_blocks_.clear();
+
+    if (vertices_.empty())
+        return;
+
+    const size_t faces_count = GetFacesCount();
+    face_clusters_.reserve((faces_count + kClusterSize - 1) / kClusterSize);
+
+    std::vector<uint32_t> vertex_blocks;
+
+    indices_.Visit([&](const auto *indices, size_t) {
+        for (size_t first_face = 0; first_face < faces_count; first_face += kClusterSize) {
+            const size_t end_face = std::min(first_face + kClusterSize, faces_count);
+
+            FaceCluster cluster = {};
+
+            // Bounding sphere around the center of the bounding box.
+            Vector3 min = vertices_[indices[first_face * 3]].position;
+            Vector3 max = min;
+
+            for (size_t corner = first_face * 3; corner < end_face * 3; corner++) {
+                const Vector3 &position = vertices_[indices[corner]].position;
+
+                for (int axis = 0; axis < 3; axis++) {
+                    min[axis] = std::min(min[axis], position[axis]);
+                    max[axis] = std::max(max[axis], position[axis]);
+                }
+            }
+
+            cluster.center = (min + max) / 2;
+
+            float radius_squared = 0;
+            for (size_t corner = first_face * 3; corner < end_face * 3; corner++)
+                radius_squared = std::max(radius_squared,
+                                          (vertices_[indices[corner]].position - cluster.center).GetLengthSquared());
+
+            cluster.radius = std::sqrt(radius_squared);
+
+            // Normal cone around the average normal.
+            bool has_degenerate_faces = false;
+            Vector3 axis = Vector3::Zero();
+
+            for (size_t face = first_face; face < end_face; face++) {
+                const Vector3 &normal = face_planes_[face].normal;
+
+                has_degenerate_faces |= normal.GetLengthSquared() == 0;
+                axis += normal;
+            }
+
+            const float axis_length = axis.GetLength();
+            cluster.cone_sine = 1;
+
+            // The axis is a unit vector even when the cone is disabled, the cluster test relies on it.
+            if (axis_length > 0)
+                axis /= axis_length;
+
+            if (!has_degenerate_faces && axis_length > 0) {
+                float min_dot = 1;
+                for (size_t face = first_face; face < end_face; face++)
+                    min_dot = std::min(min_dot, face_planes_[face].normal.Dot(axis));
+
+                // The cone is widened a little, so the rounding errors don't make it too narrow.
+                if (min_dot > 0)
+                    cluster.cone_sine = std::min(1.f, std::sqrt(1 - min_dot * min_dot) + kConeSineMargin);
+            }
+
+            cluster.cone_axis = axis;
+
+            // Distinct vertex blocks.
+            vertex_blocks.clear();
+            for (size_t corner = first_face * 3; corner < end_face * 3; corner++)
+                vertex_blocks.push_back(static_cast<uint32_t>(indices[corner] / kVertexBlockSize));
+
+            std::sort(vertex_blocks.begin(), vertex_blocks.end());
+            vertex_blocks.erase(std::unique(vertex_blocks.begin(), vertex_blocks.end()), vertex_blocks.end());
+
+            cluster.first_vertex_block = static_cast<uint32_t>(cluster_vertex_blocks_.size());
+            cluster.vertex_blocks_count = static_cast<uint32_t>(vertex_blocks.size());
+            cluster_vertex_blocks_.insert(cluster_vertex_blocks_.end(), vertex_blocks.begin(), vertex_blocks.end());
+
+            face_clusters_.push_back(cluster);
+        }
+    });
+}
+
+void Mesh::SetVertexLayout(VertexLayout layout) {
+    vertex_layout_ = layout;
+    UpdateVertexStreams();
 }
 
-const std::vector<Mesh::Vertex> &Mesh::GetVertices() const {
-    return vertices_;
+Mesh::VertexLayout Mesh::GetVertexLayout() const {
+    return vertex_layout_;
 }
 
-const std::vector<Mesh::Face> &Mesh::GetFaces() const {
-    return faces_;
-}
\ No newline at end of file
+const Mesh::VertexStreams &Mesh::GetVertexStreams() const {
+    assert(vertex_layout_ == VertexLayout::kStructureOfArrays && "Mesh doesn't use the structure of arrays layout.");
+    return vertex_streams_;
+}
+
+void Mesh::UpdateVertexStreams() {
+    if (vertex_layout_ != VertexLayout::kStructureOfArrays) {
+        vertex_streams_ = VertexStreams();
+        return;
+    }
+
+    const memory::ArrayView<Vertex> vertices = GetVertices();
+    const size_t count = vertices.size();
+    const size_t padded_count = (count + VertexStreams::kPadding - 1) / VertexStreams::kPadding * VertexStreams::kPadding;
+
+    vertex_streams_.x.assign(padded_count, 0.f);
+    vertex_streams_.y.assign(padded_count, 0.f);
+    vertex_streams_.z.assign(padded_count, 0.f);
+    vertex_streams_.colors.resize(count);
+
+    for (size_t i = 0; i < count; i++) {
+        const Vertex &vertex = vertices[i];
+
+        vertex_streams_.x[i] = vertex.position[0];
+        vertex_streams_.y[i] = vertex.position[1];
+        vertex_streams_.z[i] = vertex.position[2];
+        vertex_streams_.colors[i] = vertex.color;
+    }
+}
@@ -1,10 +1,16 @@
 #pragma once
 
+#include <memory>
+#include <string>
 #include <vector>
 
+#include "index_buffer.h"
+#include "math/bounding_volumes.h"
 #include "math/vector.h"
 #include "math/color.h"
 #include "math/matrix.h"
+#include "memory/aligned_allocator.h"
+#include "memory/array_view.h"
 
 class Mesh {
 public:
@@ -13,21 +19,199 @@ public:
         Color color;
     };
 
-    struct Face {
-        std::vector<uint32_t> indices;
+    // Plane of a face in the object space: normal.Dot(point) == distance for the points of the face.
+    // Degenerate faces have a zero normal.
+    struct FacePlane {
+        Vector3 normal;
+        float distance;
+    };
+
+    // Number of consecutive faces in a FaceCluster.
+    static constexpr size_t kClusterSize = 64;
+
+    // Number of consecutive vertices in a vertex block, the unit in which the faces of a cluster refer to vertices.
+    static constexpr size_t kVertexBlockSize = 64;
+
+    /**
+     * Bounds of kClusterSize consecutive faces, so they can be culled together.
+     * The last cluster may have fewer faces.
+     */
+    struct FaceCluster {
+        // Bounding sphere of the faces.
+        Vector3 center;
+        float radius;
+
+        // The face normals are within the cone around the axis, whose half-angle has this sine.
+        // The sine is one when the cluster can't be culled as a whole, e.g. it has normals in opposite directions.
+        Vector3 cone_axis;
+        float cone_sine;
+
+        // Range of GetClusterVertexBlocks with the distinct vertex blocks the faces use, in ascending order.
+        uint32_t first_vertex_block;
+        uint32_t vertex_blocks_count;
+    };
+
+    // Bounds of the vertex positions in the object space.
+    struct Bounds {
+        BoundingBox box;
+
+        // Centered on the box.
+        BoundingSphere sphere;
+    };
+
+    // Range of faces that belong to the same object and group, and use the same material.
+    struct SubMesh {
+        std::string object;
+        std::string group;
+        std::string material;
+
+        size_t first_face;
+        size_t faces_count;
+    };
+
+    enum class VertexLayout {
+        // Only the array of Vertex structures is stored.
+        kArrayOfStructures,
+
+        // Positions are also stored as separate aligned X, Y and Z streams, so they can be processed by SIMD.
+        kStructureOfArrays
+    };
+
+    // Vertex streams of the structure of arrays layout.
+    struct VertexStreams {
+        // Number of vertices the streams are padded to a multiple of. Padding positions are zero.
+        static constexpr size_t kPadding = 8;
+
+        memory::AlignedVector<float> x;
+        memory::AlignedVector<float> y;
+        memory::AlignedVector<float> z;
+        std::vector<Color> colors;
     };
 
     void SetVertices(std::vector<Vertex> &&vertices);
 
-    void SetFaces(std::vector<Face> &&faces);
+    void SetIndices(IndexBuffer &&indices);
 
+    // The mesh copies its external arrays before transforming them.
     void Transform(const Matrix4& transform);
 
-    const std::vector<Vertex>& GetVertices() const;
+    memory::ArrayView<Vertex> GetVertices() const;
+
+    // Triangle vertex indices, three per face.
+    const IndexBuffer& GetIndices() const;
+
+    size_t GetFacesCount() const;
+
+    // Computed when the vertices are set, and when the mesh is transformed.
+    const Bounds &GetBounds() const;
+
+    // The face planes and clusters are computed when the vertices or the indices are set,
+    // and when the mesh is transformed.
+    memory::ArrayView<FacePlane> GetFacePlanes() const;
+
+    memory::ArrayView<FaceCluster> GetFaceClusters() const;
+
+    memory::ArrayView<uint32_t> GetClusterVertexBlocks() const;
+
+public:
+    // The indices are given per face corner, in the same order as the vertex indices.
+    void SetNormals(std::vector<Vector3> &&normals, IndexBuffer &&normal_indices);
+
+    void SetTextureCoordinates(std::vector<Vector2> &&texture_coordinates, IndexBuffer &&texture_coordinate_indices);
+
+    bool HasNormals() const;
+
+    memory::ArrayView<Vector3> GetNormals() const;
+
+    const IndexBuffer& GetNormalIndices() const;
+
+    bool HasTextureCoordinates() const;
 
-    const std::vector<Face>& GetFaces() const;
+    memory::ArrayView<Vector2> GetTextureCoordinates() const;
+
+    const IndexBuffer& GetTextureCoordinateIndices() const;
+
+    /**
+     * Replaces the normals by smooth vertex normals: the normals of the faces around every vertex,
+     * averaged with weights proportional to the face areas. They are indexed like the positions.
+     * ObjParser computes them for the models that have no normals.
+     */
+    void ComputeSmoothNormals();
+
+public:
+    void SetSubMeshes(std::vector<SubMesh> &&sub_meshes);
+
+    // Sub-meshes in the order of their faces. They cover all the faces.
+    const std::vector<SubMesh>& GetSubMeshes() const;
+
+public:
+    // Arrays of a mesh that may be external.
+    struct ExternalArrays {
+        memory::ArrayView<Vertex> vertices;
+        memory::ArrayView<FacePlane> face_planes;
+        memory::ArrayView<FaceCluster> face_clusters;
+        memory::ArrayView<uint32_t> cluster_vertex_blocks;
+        memory::ArrayView<Vector3> normals;
+        memory::ArrayView<Vector2> texture_coordinates;
+    };
+
+    /**
+     * Makes the mesh refer to arrays it doesn't own instead of copying them, e.g. the blocks of a mapped mesh cache.
+     * The storage keeps them alive, and is shared by the copies of the mesh. The bounds are given with them,
+     * so the vertices aren't read.
+     */
+    void SetExternalArrays(std::shared_ptr<const void> storage, const ExternalArrays &arrays, const Bounds &bounds);
+
+    bool HasExternalArrays() const;
+
+public:
+    void SetVertexLayout(VertexLayout layout);
+
+    VertexLayout GetVertexLayout() const;
+
+    // Available only with the structure of arrays layout.
+    const VertexStreams &GetVertexStreams() const;
+
+private:
+    // Copies the external arrays, so they can be modified.
+    void CopyExternalArrays();
+
+    void UpdateBounds();
+
+    void UpdateFacePlanes();
+
+    void UpdateFaceClusters();
+
+    void UpdateVertexStreams();
+
+private:
+    static constexpr float kConeSineMargin = 1e-3f;
 
 protected:
     std::vector<Vertex> vertices_;
-    std::vector<Face> faces_;
-};
\ No newline at end of file
+    IndexBuffer indices_;
+
+    Bounds bounds_ = {};
+
+    std::vector<FacePlane> face_planes_;
+    std::vector<FaceCluster> face_clusters_;
+    std::vector<uint32_t> cluster_vertex_blocks_;
+
+protected:
+    std::vector<Vector3> normals_;
+    IndexBuffer normal_indices_;
+
+    std::vector<Vector2> texture_coordinates_;
+    IndexBuffer texture_coordinate_indices_;
+
+    std::vector<SubMesh> sub_meshes_;
+
+protected:
+    // Used instead of the vectors above when there is a storage.
+    std::shared_ptr<const void> storage_;
+    ExternalArrays external_arrays_;
+
+protected:
+    VertexLayout vertex_layout_ = VertexLayout::kArrayOfStructures;
+    VertexStreams vertex_streams_;
+};
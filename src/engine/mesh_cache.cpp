@@ -0,0 +1,401 @@
+#include <algorithm>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <string_view>
+#include <system_error>
+#include <type_traits>
+#include <vector>
+
+#include "mesh_cache.h"
+#include "io/mapped_file.h"
+
+namespace {
+
+    enum Block {
+        kVertices,
+        kIndices,
+        kFacePlanes,
+        kFaceClusters,
+        kClusterVertexBlocks,
+        kNormals,
+        kNormalIndices,
+        kTextureCoordinates,
+        kTextureCoordinateIndices,
+        kSubMeshes,
+        kNames,
+        kBlocksCount
+    };
+
+    struct BlockEntry {
+        uint64_t offset;
+        uint64_t count;
+        uint32_t element_size;
+        uint32_t reserved;
+    };
+
+    struct Header {
+        char magic[8];
+        uint32_t version;
+
+        // Reads as a different value on a machine with a different byte order.
+        uint32_t byte_order;
+
+        uint32_t vertex_size;
+        uint32_t face_plane_size;
+        uint32_t face_cluster_size;
+        uint32_t cluster_size;
+        uint32_t vertex_block_size;
+        uint32_t normal_size;
+        uint32_t texture_coordinate_size;
+        uint32_t sub_mesh_size;
+
+        uint64_t source_size;
+        int64_t source_modification_time;
+
+        Mesh::Bounds bounds;
+
+        BlockEntry blocks[kBlocksCount];
+
+        uint64_t file_size;
+        uint64_t blocks_checksum;
+
+        // Checksum of the header up to this field.
+        uint64_t header_checksum;
+    };
+
+    // Sub-mesh with its names as ranges of the names block.
+    struct SubMeshRecord {
+        uint64_t first_face;
+        uint64_t faces_count;
+
+        uint64_t name_offsets[3];
+        uint64_t name_sizes[3];
+    };
+
+    static_assert(std::is_trivially_copyable_v<Mesh::Vertex> && std::is_trivially_copyable_v<Mesh::FacePlane> &&
+                  std::is_trivially_copyable_v<Mesh::FaceCluster> &&
+                  std::is_trivially_copyable_v<Mesh::Bounds> && std::is_trivially_copyable_v<Vector3> &&
+                  std::is_trivially_copyable_v<Vector2>,
+                  "Stored types must be trivially copyable");
+
+    constexpr char kMagic[8] = {'M', 'E', 'S', 'H', 'C', 'A', 'C', 'H'};
+    constexpr uint32_t kByteOrder = 0x01020304;
+
+}
+
+static size_t AlignUp(size_t size, size_t alignment) {
+    return (size + alignment - 1) / alignment * alignment;
+}
+
+static uint64_t RotateLeft(uint64_t value, int bits) {
+    return (value << bits) | (value >> (64 - bits));
+}
+
+// Rounds of xxHash64 in four independent lanes, so the checksum of large blocks runs close to the memory speed.
+static uint64_t Checksum(const void *data, size_t size) {
+    constexpr uint64_t kPrime1 = 0x9E3779B185EBCA87ull;
+    constexpr uint64_t kPrime2 = 0xC2B2AE3D27D4EB4Full;
+
+    const auto round = [](uint64_t accumulator, uint64_t input) {
+        return RotateLeft(accumulator + input * kPrime2, 31) * kPrime1;
+    };
+
+    const char *bytes = static_cast<const char *>(data);
+    uint64_t lanes[4] = {kPrime1 + kPrime2, kPrime2, 0, 0 - kPrime1};
+
+    size_t offset = 0;
+    for (; offset + 32 <= size; offset += 32) {
+        for (size_t lane = 0; lane < 4; lane++) {
+            uint64_t word;
+            std::memcpy(&word, bytes + offset + lane * 8, sizeof(word));
+            lanes[lane] = round(lanes[lane], word);
+        }
+    }
+
+    for (; offset < size; offset++)
+        lanes[0] = round(lanes[0], static_cast<unsigned char>(bytes[offset]));
+
+    uint64_t checksum = size;
+    for (uint64_t lane : lanes)
+        checksum = round(checksum ^ lane, lane);
+
+    return checksum;
+}
+
+bool MeshCache::GetSourceStamp(const std::string &path, SourceStamp *stamp) {
+    std::error_code error;
+
+    const uintmax_t size = std::filesystem::file_size(path, error);
+    if (error)
+        return false;
+
+    const std::filesystem::file_time_type time = std::filesystem::last_write_time(path, error);
+    if (error)
+        return false;
+
+    stamp->size = size;
+    stamp->modification_time = static_cast<int64_t>(time.time_since_epoch().count());
+
+    return true;
+}
+
+std::string MeshCache::GetCachePath(const std::string &source_path) {
+    return source_path + ".meshcache";
+}
+
+bool MeshCache::Write(const Mesh &mesh, const SourceStamp &source, const std::string &path) {
+    Header header = {};
+
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kVersion;
+    header.byte_order = kByteOrder;
+    header.vertex_size = sizeof(Mesh::Vertex);
+    header.face_plane_size = sizeof(Mesh::FacePlane);
+    header.face_cluster_size = sizeof(Mesh::FaceCluster);
+    header.cluster_size = Mesh::kClusterSize;
+    header.vertex_block_size = Mesh::kVertexBlockSize;
+    header.normal_size = sizeof(Vector3);
+    header.texture_coordinate_size = sizeof(Vector2);
+    header.sub_mesh_size = sizeof(SubMeshRecord);
+    header.source_size = source.size;
+    header.source_modification_time = source.modification_time;
+
+    const memory::ArrayView<Mesh::Vertex> vertices = mesh.GetVertices();
+
+    header.bounds = mesh.GetBounds();
+
+    std::vector<char> file(AlignUp(sizeof(Header), kBlockAlignment));
+
+    const auto append_block = [&](Block block, const void *data, size_t count, size_t element_size) {
+        header.blocks[block] = BlockEntry{file.size(), count, static_cast<uint32_t>(element_size), 0};
+
+        if (count != 0) {
+            const char *bytes = static_cast<const char *>(data);
+            file.insert(file.end(), bytes, bytes + count * element_size);
+        }
+        file.resize(AlignUp(file.size(), kBlockAlignment));
+    };
+
+    const auto append_indices = [&](Block block, const IndexBuffer &indices) {
+        indices.Visit([&](const auto *data, size_t triangles_count) {
+            append_block(block, data, triangles_count * 3, sizeof(*data));
+        });
+    };
+
+    append_block(kVertices, vertices.data(), vertices.size(), sizeof(Mesh::Vertex));
+    append_indices(kIndices, mesh.GetIndices());
+    append_block(kFacePlanes, mesh.GetFacePlanes().data(), mesh.GetFacePlanes().size(), sizeof(Mesh::FacePlane));
+    append_block(kFaceClusters, mesh.GetFaceClusters().data(), mesh.GetFaceClusters().size(),
+                 sizeof(Mesh::FaceCluster));
+    append_block(kClusterVertexBlocks, mesh.GetClusterVertexBlocks().data(), mesh.GetClusterVertexBlocks().size(),
+                 sizeof(uint32_t));
+    append_block(kNormals, mesh.GetNormals().data(), mesh.GetNormals().size(), sizeof(Vector3));
+    append_indices(kNormalIndices, mesh.GetNormalIndices());
+    append_block(kTextureCoordinates, mesh.GetTextureCoordinates().data(), mesh.GetTextureCoordinates().size(),
+                 sizeof(Vector2));
+    append_indices(kTextureCoordinateIndices, mesh.GetTextureCoordinateIndices());
+
+    std::vector<SubMeshRecord> sub_meshes;
+    std::string names;
+
+    for (const Mesh::SubMesh &sub_mesh : mesh.GetSubMeshes()) {
+        SubMeshRecord record = {};
+        record.first_face = sub_mesh.first_face;
+        record.faces_count = sub_mesh.faces_count;
+
+        const std::string *sub_mesh_names[3] = {&sub_mesh.object, &sub_mesh.group, &sub_mesh.material};
+
+        for (int name = 0; name < 3; name++) {
+            record.name_offsets[name] = names.size();
+            record.name_sizes[name] = sub_mesh_names[name]->size();
+            names += *sub_mesh_names[name];
+        }
+
+        sub_meshes.push_back(record);
+    }
+
+    append_block(kSubMeshes, sub_meshes.data(), sub_meshes.size(), sizeof(SubMeshRecord));
+    append_block(kNames, names.data(), names.size(), 1);
+
+    const size_t blocks_offset = AlignUp(sizeof(Header), kBlockAlignment);
+
+    header.file_size = file.size();
+    header.blocks_checksum = Checksum(file.data() + blocks_offset, file.size() - blocks_offset);
+    header.header_checksum = Checksum(&header, offsetof(Header, header_checksum));
+
+    std::memcpy(file.data(), &header, sizeof(header));
+
+    const std::string temporary_path = path + ".tmp";
+
+    FILE *output = std::fopen(temporary_path.c_str(), "wb");
+    if (!output)
+        return false;
+
+    const bool written = std::fwrite(file.data(), 1, file.size(), output) == file.size();
+    const bool closed = std::fclose(output) == 0;
+
+    std::error_code error;
+
+    if (written && closed)
+        std::filesystem::rename(temporary_path, path, error);
+
+    if (!written || !closed || error) {
+        std::filesystem::remove(temporary_path, error);
+        return false;
+    }
+
+    return true;
+}
+
+// Checks the block lies within the file. The offsets are checked to be aligned separately.
+static bool IsBlockValid(const BlockEntry &block, size_t element_size, size_t blocks_offset, size_t file_size) {
+    if (block.count == 0)
+        return true;
+
+    return block.element_size == element_size && block.offset >= blocks_offset && block.offset <= file_size &&
+           block.count <= (file_size - block.offset) / element_size;
+}
+
+static bool IsIndexBlockValid(const BlockEntry &block, size_t blocks_offset, size_t file_size) {
+    return IsBlockValid(block, block.element_size == 2 ? 2 : 4, blocks_offset, file_size) && block.count % 3 == 0;
+}
+
+template<typename Element>
+static memory::ArrayView<Element> GetBlockArray(const char *data, const BlockEntry &block) {
+    return memory::ArrayView<Element>(reinterpret_cast<const Element *>(data + block.offset), block.count);
+}
+
+std::shared_ptr<Mesh> MeshCache::Load(const std::string &path, const SourceStamp &source, bool verify_blocks) {
+    auto file = std::make_shared<io::MappedFile>();
+    if (!file->Open(path, io::MappedFile::AccessPattern::kNormal) || file->GetSize() < sizeof(Header))
+        return nullptr;
+
+    const char *data = file->GetData();
+    const size_t file_size = file->GetSize();
+
+    Header header;
+    std::memcpy(&header, data, sizeof(header));
+
+    if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 || header.version != kVersion ||
+        header.byte_order != kByteOrder || header.vertex_size != sizeof(Mesh::Vertex) ||
+        header.face_plane_size != sizeof(Mesh::FacePlane) || header.face_cluster_size != sizeof(Mesh::FaceCluster) ||
+        header.cluster_size != Mesh::kClusterSize || header.vertex_block_size != Mesh::kVertexBlockSize ||
+        header.normal_size != sizeof(Vector3) || header.texture_coordinate_size != sizeof(Vector2) ||
+        header.sub_mesh_size != sizeof(SubMeshRecord))
+        return nullptr;
+
+    if (header.source_size != source.size || header.source_modification_time != source.modification_time)
+        return nullptr;
+
+    const size_t blocks_offset = AlignUp(sizeof(Header), kBlockAlignment);
+
+    if (header.header_checksum != Checksum(&header, offsetof(Header, header_checksum)) ||
+        header.file_size != file_size || file_size < blocks_offset)
+        return nullptr;
+
+    if (verify_blocks && header.blocks_checksum != Checksum(data + blocks_offset, file_size - blocks_offset))
+        return nullptr;
+
+    const BlockEntry *blocks = header.blocks;
+
+    for (int block = 0; block < kBlocksCount; block++) {
+        if (blocks[block].offset % kBlockAlignment != 0)
+            return nullptr;
+    }
+
+    const bool blocks_valid = IsBlockValid(blocks[kVertices], sizeof(Mesh::Vertex), blocks_offset, file_size) &&
+                              IsIndexBlockValid(blocks[kIndices], blocks_offset, file_size) &&
+                              IsBlockValid(blocks[kFacePlanes], sizeof(Mesh::FacePlane), blocks_offset, file_size) &&
+                              IsBlockValid(blocks[kFaceClusters], sizeof(Mesh::FaceCluster), blocks_offset,
+                                           file_size) &&
+                              IsBlockValid(blocks[kClusterVertexBlocks], sizeof(uint32_t), blocks_offset,
+                                           file_size) &&
+                              IsBlockValid(blocks[kNormals], sizeof(Vector3), blocks_offset, file_size) &&
+                              IsIndexBlockValid(blocks[kNormalIndices], blocks_offset, file_size) &&
+                              IsBlockValid(blocks[kTextureCoordinates], sizeof(Vector2), blocks_offset, file_size) &&
+                              IsIndexBlockValid(blocks[kTextureCoordinateIndices], blocks_offset, file_size) &&
+                              IsBlockValid(blocks[kSubMeshes], sizeof(SubMeshRecord), blocks_offset, file_size) &&
+                              IsBlockValid(blocks[kNames], 1, blocks_offset, file_size);
+    if (!blocks_valid)
+        return nullptr;
+
+    // Every face has a plane and a cluster. Every face corner has a normal and a texture coordinate, or none has.
+    const uint64_t indices_count = blocks[kIndices].count;
+    const uint64_t clusters_count = (indices_count / 3 + Mesh::kClusterSize - 1) / Mesh::kClusterSize;
+
+    if (blocks[kFacePlanes].count != indices_count / 3 || blocks[kFaceClusters].count != clusters_count ||
+        (blocks[kNormals].count != 0 && blocks[kNormalIndices].count != indices_count) ||
+        (blocks[kTextureCoordinates].count != 0 && blocks[kTextureCoordinateIndices].count != indices_count))
+        return nullptr;
+
+    const auto get_block = [&](Block block) {
+        return data + blocks[block].offset;
+    };
+
+    const auto create_index_buffer = [&](Block block) {
+        const IndexBuffer::Type type = blocks[block].element_size == 2 ? IndexBuffer::Type::kUInt16
+                                                                       : IndexBuffer::Type::kUInt32;
+        return IndexBuffer(type, get_block(block), blocks[block].count, file);
+    };
+
+    std::vector<Mesh::SubMesh> sub_meshes;
+    sub_meshes.reserve(blocks[kSubMeshes].count);
+
+    const std::string_view names(get_block(kNames), blocks[kNames].count);
+    const uint64_t faces_count = indices_count / 3;
+
+    for (uint64_t i = 0; i < blocks[kSubMeshes].count; i++) {
+        SubMeshRecord record;
+        std::memcpy(&record, get_block(kSubMeshes) + i * sizeof(SubMeshRecord), sizeof(record));
+
+        if (record.first_face > faces_count || record.faces_count > faces_count - record.first_face)
+            return nullptr;
+
+        Mesh::SubMesh sub_mesh;
+        sub_mesh.first_face = record.first_face;
+        sub_mesh.faces_count = record.faces_count;
+
+        std::string *sub_mesh_names[3] = {&sub_mesh.object, &sub_mesh.group, &sub_mesh.material};
+
+        for (int name = 0; name < 3; name++) {
+            if (record.name_offsets[name] > names.size() ||
+                record.name_sizes[name] > names.size() - record.name_offsets[name])
+                return nullptr;
+
+            *sub_mesh_names[name] = names.substr(record.name_offsets[name], record.name_sizes[name]);
+        }
+
+        sub_meshes.push_back(std::move(sub_mesh));
+    }
+
+    Mesh::ExternalArrays arrays;
+    arrays.vertices = GetBlockArray<Mesh::Vertex>(data, blocks[kVertices]);
+    arrays.face_planes = GetBlockArray<Mesh::FacePlane>(data, blocks[kFacePlanes]);
+    arrays.face_clusters = GetBlockArray<Mesh::FaceCluster>(data, blocks[kFaceClusters]);
+    arrays.cluster_vertex_blocks = GetBlockArray<uint32_t>(data, blocks[kClusterVertexBlocks]);
+    arrays.normals = GetBlockArray<Vector3>(data, blocks[kNormals]);
+    arrays.texture_coordinates = GetBlockArray<Vector2>(data, blocks[kTextureCoordinates]);
+
+    for (const Mesh::FaceCluster &cluster : arrays.face_clusters) {
+        if (cluster.first_vertex_block > arrays.cluster_vertex_blocks.size() ||
+            cluster.vertex_blocks_count > arrays.cluster_vertex_blocks.size() - cluster.first_vertex_block)
+            return nullptr;
+    }
+
+    auto mesh = std::make_shared<Mesh>();
+
+    mesh->SetIndices(create_index_buffer(kIndices));
+
+    if (blocks[kNormals].count != 0)
+        mesh->SetNormals({}, create_index_buffer(kNormalIndices));
+
+    if (blocks[kTextureCoordinates].count != 0)
+        mesh->SetTextureCoordinates({}, create_index_buffer(kTextureCoordinateIndices));
+
+    mesh->SetSubMeshes(std::move(sub_meshes));
+    mesh->SetExternalArrays(file, arrays, header.bounds);
+
+    return mesh;
+}
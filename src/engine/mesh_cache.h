@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "mesh.h"
+
+/**
+ * Binary mesh format that is loaded without parsing: the file is mapped, and the arrays of the mesh point into
+ * the mapping.
+ *
+ * The file is a header followed by blocks of the raw arrays: vertices, indices, face planes and clusters, normals
+ * and their indices, texture coordinates and their indices, sub-meshes and their names. The header records
+ * the format version, the byte order and the sizes of the stored types, the size and modification time of the source
+ * file, the bounding box and sphere of the positions, and the checksums of the header and of the blocks.
+ */
+class MeshCache {
+public:
+    // Identity of the file a cache is made from. A cache made from a different one is stale.
+    struct SourceStamp {
+        uint64_t size = 0;
+        int64_t modification_time = 0;
+    };
+
+    static bool GetSourceStamp(const std::string &path, SourceStamp *stamp);
+
+    // Path of the cache of a source file, next to it.
+    static std::string GetCachePath(const std::string &source_path);
+
+    /**
+     * Writes the file next to the cache and renames it over the cache, so a partially written cache is never read.
+     *
+     * @return False if the file can't be written.
+     */
+    static bool Write(const Mesh &mesh, const SourceStamp &source, const std::string &path);
+
+    /**
+     * Maps the cache. The mapping is released when the mesh and its copies are destroyed,
+     * or when the mesh copies the arrays on a modification. The header and the sizes of the blocks are always
+     * checked, the contents of the blocks only on request: reading them all would cost as much as the file size.
+     * The indices are not range checked, so a cache modified by something else than Write should be verified.
+     *
+     * @param verify_blocks Check the checksum of the blocks too.
+     * @return Null if the cache is missing, corrupted, written by another version of the format,
+     *         or made from another source.
+     */
+    static std::shared_ptr<Mesh> Load(const std::string &path, const SourceStamp &source, bool verify_blocks = false);
+
+private:
+    // Alignment of the blocks in the file, enough for any vector type.
+    static constexpr size_t kBlockAlignment = 64;
+
+    static constexpr uint32_t kVersion = 5;
+};
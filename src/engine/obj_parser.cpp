@@ -1,163 +1,535 @@
+#include <algorithm>
+#include <cassert>
+#include <charconv>
+#include <cstring>
+#include <limits>
+
 #include "obj_parser.h"
+#include "mesh_cache.h"
 
-std::shared_ptr<Mesh> ObjParser::Parse(const std::string &text) {
-    return Parse(text.c_str(), text.size());
+std::shared_ptr<Mesh> ObjParser::Parse(const std::string &text, jobs::JobSystem *job_system) {
+    return Parse(text.c_str(), text.size(), job_system);
 }
 
-std::shared_ptr<Mesh> ObjParser::Parse(const char *text, size_t length) {
+std::shared_ptr<Mesh> ObjParser::Parse(const char *text, size_t length, jobs::JobSystem *job_system) {
     ObjParser parser;
     parser.SetText(text, length);
+    parser.SetJobSystem(job_system);
+
+    if (!parser.Parse())
+        return nullptr;
+
+    return parser.GetMesh();
+}
+
+std::shared_ptr<Mesh> ObjParser::ParseFile(const std::string &path, jobs::JobSystem *job_system, bool use_cache,
+                                           bool verify_cache) {
+    // The stamp is taken before reading, so a file modified meanwhile makes the cache stale.
+    MeshCache::SourceStamp source;
+    use_cache = use_cache && MeshCache::GetSourceStamp(path, &source);
+
+    const std::string cache_path = MeshCache::GetCachePath(path);
+
+    if (use_cache) {
+        if (std::shared_ptr<Mesh> mesh = MeshCache::Load(cache_path, source, verify_cache))
+            return mesh;
+    }
+
+    io::MappedFile file;
+    if (!file.Open(path, io::MappedFile::AccessPattern::kSequential))
+        return nullptr;
+
+    ObjParser parser;
+    parser.SetText(file.GetData(), file.GetSize());
+    parser.SetJobSystem(job_system);
+    parser.mapped_file_ = &file;
+
     if (!parser.Parse())
         return nullptr;
 
+    if (use_cache)
+        MeshCache::Write(*parser.GetMesh(), source, cache_path);
+
     return parser.GetMesh();
 }
 
 void ObjParser::SetText(const char *text, size_t length) {
-    text_ = text;
-    end_ = text + length;
+    text_ = std::string_view(text, length);
+}
 
-    cursor_ = text_;
+void ObjParser::SetJobSystem(jobs::JobSystem *job_system) {
+    job_system_ = job_system;
+}
+
+static bool IsSpace(char c) {
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+// Returns the next whitespace separated token of the line and removes it from the line.
+static std::string_view NextToken(std::string_view &line) {
+    size_t begin = 0;
+    while (begin < line.size() && IsSpace(line[begin]))
+        begin++;
+
+    size_t end = begin;
+    while (end < line.size() && !IsSpace(line[end]))
+        end++;
+
+    const std::string_view token = line.substr(begin, end - begin);
+    line.remove_prefix(end);
+
+    return token;
+}
+
+static bool ParseFloat(std::string_view token, float *value) {
+    // from_chars doesn't accept the plus sign.
+    if (!token.empty() && token[0] == '+')
+        token.remove_prefix(1);
+
+    const char *end = token.data() + token.size();
+    const std::from_chars_result result = std::from_chars(token.data(), end, *value);
+
+    return result.ec == std::errc() && result.ptr == end;
+}
+
+// Returns the rest of the line without the surrounding whitespaces.
+static std::string_view Trim(std::string_view line) {
+    while (!line.empty() && IsSpace(line.front()))
+        line.remove_prefix(1);
+
+    while (!line.empty() && IsSpace(line.back()))
+        line.remove_suffix(1);
+
+    return line;
 }
 
 bool ObjParser::Parse() {
-    ResetCursor();
+    SplitIntoChunks();
 
-    const uint32_t vertex_count = CountVertices();
+    ForEachChunk([this](size_t chunk) {
+        ParseChunk(&chunks_[chunk]);
+    });
 
-    ResetCursor();
+    bool parsed = true;
+    for (const Chunk &chunk : chunks_)
+        parsed &= !chunk.failed;
 
-    std::vector<Mesh::Vertex> vertices;
-    vertices.resize(vertex_count);
+    auto mesh = std::make_shared<Mesh>();
+    parsed = parsed && StitchChunks(mesh.get());
 
-    Mesh::Vertex *vertex = &vertices[0];
+    chunks_.clear();
 
-    std::vector<Mesh::Face> faces;
+    if (!parsed)
+        return false;
 
-    while (!EndReached()) {
-        if (Current() == '#') {
-            NextLine();
-            continue;
+    mesh_ = mesh;
+    return true;
+}
+
+template<typename Function>
+void ObjParser::ForEachChunk(Function function) {
+    const auto run = [&](size_t begin, size_t end) {
+        for (size_t chunk = begin; chunk < end; chunk++)
+            function(chunk);
+    };
+
+    if (job_system_)
+        job_system_->ParallelFor(chunks_.size(), 1, run);
+    else
+        run(0, chunks_.size());
+}
+
+void ObjParser::SplitIntoChunks() {
+    chunks_.clear();
+
+    if (!job_system_ || job_system_->GetThreadsCount() == 1 || text_.size() <= kChunkSize) {
+        chunks_.emplace_back();
+        chunks_.back().text = text_;
+        return;
+    }
+
+    size_t begin = 0;
+
+    while (begin < text_.size()) {
+        size_t end = std::min(begin + kChunkSize, text_.size());
+
+        // Extend the chunk to the end of its last line.
+        const size_t line_end = text_.find('\n', end - 1);
+        end = line_end == std::string_view::npos ? text_.size() : line_end + 1;
+
+        chunks_.emplace_back();
+        chunks_.back().text = text_.substr(begin, end - begin);
+
+        begin = end;
+    }
+}
+
+void ObjParser::ParseChunk(Chunk *chunk) const {
+    const char *cursor = chunk->text.data();
+    const char *end = chunk->text.data() + chunk->text.size();
+
+    const char *discarded = cursor;
+
+    while (cursor < end) {
+        if (mapped_file_ && static_cast<size_t>(cursor - discarded) >= kDiscardInterval) {
+            mapped_file_->Discard(discarded - text_.data(), cursor - discarded);
+            discarded = cursor;
         }
 
-        std::string data_type = ReadWord();
+        const auto *line_end = static_cast<const char *>(std::memchr(cursor, '\n', end - cursor));
+        if (!line_end)
+            line_end = end;
 
-        if (data_type == "v") {
-            vertex->position[0] = std::stof(ReadWord());
-            vertex->position[1] = std::stof(ReadWord());
-            vertex->position[2] = std::stof(ReadWord());
-            vertex++;
-            NextLine();
-            continue;
+        if (!ParseLine(std::string_view(cursor, line_end - cursor), chunk)) {
+            chunk->failed = true;
+            return;
         }
 
-        if (data_type == "f") {
-            Mesh::Face face;
-            face.indices.reserve(3);
+        cursor = line_end + 1;
+    }
 
-            for (size_t i = 0; i < 3; i++) {
-                int index = std::stoi(ReadWord());
+    if (mapped_file_)
+        mapped_file_->Discard(discarded - text_.data(), end - discarded);
+}
 
-                if (index < 0)
-                    index += static_cast<int>(vertex_count);
-                else
-                    index--;
+bool ObjParser::ParseLine(std::string_view line, Chunk *chunk) {
+    const std::string_view data_type = NextToken(line);
 
-                if (index < 0 || index >= vertex_count)
-                    return false;
+    if (data_type == "v")
+        return ParseVertex(line, chunk);
 
-                face.indices.push_back(index);
-            }
+    if (data_type == "vt")
+        return ParseTextureCoordinate(line, chunk);
 
-            faces.emplace_back(std::move(face));
-            NextLine();
-            continue;
-        }
+    if (data_type == "vn")
+        return ParseNormal(line, chunk);
+
+    if (data_type == "f")
+        return ParseFace(line, chunk);
 
-        NextLine();
+    if (data_type == "o" || data_type == "g" || data_type == "usemtl") {
+        const SubMeshField field = data_type == "o" ? kObject : data_type == "g" ? kGroup : kMaterial;
+        chunk->sub_mesh_changes.push_back(SubMeshChange{chunk->faces_count, field, Trim(line)});
+        return true;
     }
 
-    mesh_ = std::make_shared<Mesh>();
-    mesh_->SetVertices(std::move(vertices));
-    mesh_->SetFaces(std::move(faces));
+    // Comments and unsupported data.
+    return true;
+}
+
+bool ObjParser::ParseVertex(std::string_view line, Chunk *chunk) {
+    Mesh::Vertex vertex{};
+
+    for (size_t i = 0; i < 3; i++) {
+        if (!ParseFloat(NextToken(line), &vertex.position[i]))
+            return false;
+    }
 
+    chunk->vertices.push_back(vertex);
     return true;
 }
 
-uint32_t ObjParser::CountVertices() {
-    uint32_t vertex = 0;
+bool ObjParser::ParseTextureCoordinate(std::string_view line, Chunk *chunk) {
+    Vector2 texture_coordinate(0, 0);
+
+    if (!ParseFloat(NextToken(line), &texture_coordinate[0]))
+        return false;
+
+    // The V coordinate is optional.
+    const std::string_view v = NextToken(line);
+    if (!v.empty() && !ParseFloat(v, &texture_coordinate[1]))
+        return false;
 
-    while (!EndReached()) {
-        SkipSpaces();
+    chunk->texture_coordinates.push_back(texture_coordinate);
+    return true;
+}
 
-        if (Current() == 'v' && Peek(1) == ' ')
-            vertex++;
+bool ObjParser::ParseNormal(std::string_view line, Chunk *chunk) {
+    Vector3 normal;
 
-        NextLine();
+    for (size_t i = 0; i < 3; i++) {
+        if (!ParseFloat(NextToken(line), &normal[i]))
+            return false;
     }
 
-    return vertex;
+    chunk->normals.push_back(normal);
+    return true;
 }
 
-std::string ObjParser::ReadWord() {
-    std::string word;
+// Parses a face element: v, v/vt, v//vn or v/vt/vn.
+static bool ParseFaceElement(std::string_view token, int64_t indices[3]) {
+    const char *cursor = token.data();
+    const char *end = token.data() + token.size();
+
+    for (size_t attribute = 0; attribute < 3; attribute++) {
+        indices[attribute] = 0;
+
+        if (attribute > 0) {
+            if (cursor == end)
+                continue;
+
+            if (*cursor != '/')
+                return false;
 
-    SkipSpaces();
+            cursor++;
 
-    while (!EndReached()) {
-        if (Current() == '\n' || Current() == ' ')
-            return word;
+            if (cursor == end || *cursor == '/')
+                continue; // The attribute is omitted.
+        }
+
+        const std::from_chars_result result = std::from_chars(cursor, end, indices[attribute]);
+        if (result.ec != std::errc())
+            return false;
+
+        // Zero is not a valid index, and the indices must fit in 32 bits.
+        const int64_t index = indices[attribute];
+        if (index == 0 || index < std::numeric_limits<int32_t>::min() ||
+            index > static_cast<int64_t>(std::numeric_limits<uint32_t>::max()))
+            return false;
 
-        word += Current();
-        Next();
+        cursor = result.ptr;
     }
 
-    return word;
+    return cursor == end;
 }
 
-void ObjParser::NextLine() {
-    while (!EndReached()) {
-        if (Current() == '\n') {
-            Next();
-            return;
+bool ObjParser::ParseFace(std::string_view line, Chunk *chunk) {
+    std::vector<Corner> &corners = chunk->corners;
+    corners.clear();
+
+    while (true) {
+        const std::string_view token = NextToken(line);
+        if (token.empty())
+            break;
+
+        Corner corner;
+        if (!ParseFaceElement(token, corner.indices))
+            return false;
+
+        corners.push_back(corner);
+    }
+
+    if (corners.size() < 3)
+        return false;
+
+    // All the elements of a face must have the same attributes.
+    for (const Corner &corner : corners) {
+        for (size_t attribute = kTextureCoordinate; attribute < kAttributesCount; attribute++) {
+            if ((corner.indices[attribute] == 0) != (corners[0].indices[attribute] == 0))
+                return false;
         }
+    }
+
+    // Triangulate as a fan around the first corner.
+    for (size_t i = 1; i + 1 < corners.size(); i++) {
+        AddCorner(corners[0], chunk);
+        AddCorner(corners[i], chunk);
+        AddCorner(corners[i + 1], chunk);
 
-        Next();
+        chunk->faces_count++;
     }
+
+    return true;
 }
 
-void ObjParser::Next() {
-    if (cursor_ == end_)
-        return;
+void ObjParser::AddCorner(const Corner &corner, Chunk *chunk) {
+    for (size_t attribute = 0; attribute < kAttributesCount; attribute++) {
+        const int64_t index = corner.indices[attribute];
+        if (index == 0)
+            continue;
+
+        IndexStream &stream = chunk->streams[attribute];
+
+        if (index < 0) {
+            // Negative indices are relative to the end of the elements read so far. The elements of the previous
+            // chunks are not known yet, so the index is stored relative to the chunk and may be negative.
+            const auto count = static_cast<int64_t>(GetAttributeCount(*chunk, static_cast<Attribute>(attribute)));
 
-    cursor_++;
+            stream.relative_indices.push_back(stream.indices.size());
+            stream.indices.push_back(static_cast<uint32_t>(index + count));
+        } else {
+            stream.indices.push_back(static_cast<uint32_t>(index - 1));
+            stream.max_index = std::max(stream.max_index, stream.indices.back());
+        }
+    }
 }
 
-bool ObjParser::EndReached() const {
-    return cursor_ == end_;
+size_t ObjParser::GetAttributeCount(const Chunk &chunk, Attribute attribute) {
+    switch (attribute) {
+        case kPosition:
+            return chunk.vertices.size();
+        case kTextureCoordinate:
+            return chunk.texture_coordinates.size();
+        case kNormal:
+            return chunk.normals.size();
+        default:
+            assert(false);
+            return 0;
+    }
 }
 
-char ObjParser::Peek(int offset) const {
-    const char *p = cursor_ + offset;
-    if (p < text_ || p >= end_)
-        return '\0';
+bool ObjParser::StitchChunks(Mesh *mesh) {
+    std::vector<uint32_t> indices[kAttributesCount];
+    bool present[kAttributesCount];
+
+    for (size_t attribute = 0; attribute < kAttributesCount; attribute++) {
+        // An attribute is kept only if every face has it. The positions are always present.
+        present[attribute] = true;
+
+        for (const Chunk &chunk : chunks_)
+            present[attribute] &= chunk.streams[attribute].indices.size() == chunk.streams[kPosition].indices.size();
+    }
+
+    if (!StitchAttribute(kPosition, &indices[kPosition]))
+        return false;
+
+    // An index of a missing texture coordinate or normal only drops that attribute, the positions are kept.
+    for (size_t attribute = kPosition + 1; attribute < kAttributesCount; attribute++) {
+        if (present[attribute] && !StitchAttribute(static_cast<Attribute>(attribute), &indices[attribute]))
+            present[attribute] = false;
+    }
+
+    const size_t corners_count = indices[kPosition].size();
+
+    mesh->SetVertices(ConcatenateElements(&Chunk::vertices));
+    mesh->SetIndices(IndexBuffer(std::move(indices[kPosition]), mesh->GetVertices().size()));
 
-    return *p;
+    std::vector<Vector2> texture_coordinates = ConcatenateElements(&Chunk::texture_coordinates);
+    if (present[kTextureCoordinate] && corners_count > 0) {
+        const size_t count = texture_coordinates.size();
+        mesh->SetTextureCoordinates(std::move(texture_coordinates),
+                                    IndexBuffer(std::move(indices[kTextureCoordinate]), count));
+    }
+
+    std::vector<Vector3> normals = ConcatenateElements(&Chunk::normals);
+    if (present[kNormal] && corners_count > 0) {
+        const size_t count = normals.size();
+        mesh->SetNormals(std::move(normals), IndexBuffer(std::move(indices[kNormal]), count));
+    } else if (corners_count > 0) {
+        // Computed once here, so that they are stored in the mesh cache and the smooth shading only reads them.
+        mesh->ComputeSmoothNormals();
+    }
+
+    mesh->SetSubMeshes(BuildSubMeshes());
+
+    return true;
 }
 
-char ObjParser::Current() const {
-    return Peek(0);
+bool ObjParser::StitchAttribute(Attribute attribute, std::vector<uint32_t> *indices) {
+    std::vector<size_t> index_offsets(chunks_.size());
+
+    size_t elements_count = 0;
+    size_t indices_count = 0;
+    uint32_t max_index = 0;
+
+    for (size_t i = 0; i < chunks_.size(); i++) {
+        IndexStream &stream = chunks_[i].streams[attribute];
+        const size_t chunk_elements_count = GetAttributeCount(chunks_[i], attribute);
+
+        // The relative indices are checked against the elements read before them, so the result is the same
+        // as when the text is parsed as a single chunk.
+        for (size_t position : stream.relative_indices) {
+            const int64_t index = static_cast<int64_t>(elements_count) + static_cast<int32_t>(stream.indices[position]);
+            if (index < 0 || index >= static_cast<int64_t>(elements_count + chunk_elements_count))
+                return false;
+
+            stream.indices[position] = static_cast<uint32_t>(index);
+            stream.max_index = std::max(stream.max_index, stream.indices[position]);
+        }
+
+        index_offsets[i] = indices_count;
+
+        elements_count += chunk_elements_count;
+        indices_count += stream.indices.size();
+        max_index = std::max(max_index, stream.max_index);
+    }
+
+    // Positive indices may refer to the elements that follow the face.
+    if (indices_count > 0 && max_index >= elements_count)
+        return false;
+
+    if (chunks_.size() == 1) {
+        *indices = std::move(chunks_[0].streams[attribute].indices);
+        return true;
+    }
+
+    indices->resize(indices_count);
+
+    ForEachChunk([&](size_t chunk) {
+        std::vector<uint32_t> &chunk_indices = chunks_[chunk].streams[attribute].indices;
+        std::copy(chunk_indices.begin(), chunk_indices.end(), indices->begin() + index_offsets[chunk]);
+
+        // Release the chunk as soon as it's copied, to lower the peak memory usage.
+        chunk_indices = std::vector<uint32_t>();
+    });
+
+    return true;
 }
 
-void ObjParser::SkipSpaces() {
-    while (!EndReached() && Current() == ' ')
-        Next();
+template<typename Element>
+std::vector<Element> ObjParser::ConcatenateElements(std::vector<Element> Chunk::*elements) {
+    if (chunks_.size() == 1)
+        return std::move(chunks_[0].*elements);
+
+    std::vector<size_t> offsets(chunks_.size());
+    size_t count = 0;
+
+    for (size_t i = 0; i < chunks_.size(); i++) {
+        offsets[i] = count;
+        count += (chunks_[i].*elements).size();
+    }
+
+    std::vector<Element> result(count);
+
+    ForEachChunk([&](size_t chunk) {
+        std::vector<Element> &chunk_elements = chunks_[chunk].*elements;
+        std::copy(chunk_elements.begin(), chunk_elements.end(), result.begin() + offsets[chunk]);
+
+        chunk_elements = std::vector<Element>();
+    });
+
+    return result;
 }
 
-void ObjParser::ResetCursor() {
-    cursor_ = text_;
+std::vector<Mesh::SubMesh> ObjParser::BuildSubMeshes() const {
+    std::vector<Mesh::SubMesh> sub_meshes;
+
+    std::string_view names[3];
+    size_t first_face = 0;
+
+    const auto end_sub_mesh = [&](size_t end_face) {
+        if (end_face > first_face) {
+            sub_meshes.push_back(Mesh::SubMesh{std::string(names[kObject]),
+                                               std::string(names[kGroup]),
+                                               std::string(names[kMaterial]),
+                                               first_face,
+                                               end_face - first_face});
+        }
+
+        first_face = end_face;
+    };
+
+    size_t face_offset = 0;
+
+    for (const Chunk &chunk : chunks_) {
+        for (const SubMeshChange &change : chunk.sub_mesh_changes) {
+            end_sub_mesh(face_offset + change.face);
+
+            names[change.field] = change.name;
+
+            // Groups belong to an object.
+            if (change.field == kObject)
+                names[kGroup] = std::string_view();
+        }
+
+        face_offset += chunk.faces_count;
+    }
+
+    end_sub_mesh(face_offset);
+
+    return sub_meshes;
 }
 
 std::shared_ptr<Mesh> ObjParser::GetMesh() const {
     return mesh_;
-}
\ No newline at end of file
+}
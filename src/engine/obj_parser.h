@@ -2,47 +2,162 @@
 
 #include <memory>
 #include <string>
+#include <string_view>
+#include <vector>
 
 #include "mesh.h"
-
-// Parser for .obj files
+#include "io/mapped_file.h"
+#include "jobs/job_system.h"
+
+/**
+ * Parser for .obj files.
+ * Reads the vertex positions, texture coordinates and normals, and the faces with their v, v/vt, v//vn or v/vt/vn
+ * elements. Faces with more than three vertices are triangulated as fans. Objects, groups and materials split
+ * the faces into sub-meshes. Texture coordinates and normals are kept only if every face has them and all their
+ * indices are valid.
+ */
 class ObjParser {
 public:
-    static std::shared_ptr<Mesh> Parse(const std::string &text);
-
-    static std::shared_ptr<Mesh> Parse(const char *text, size_t length);
+    static std::shared_ptr<Mesh> Parse(const std::string &text, jobs::JobSystem *job_system = nullptr);
+
+    static std::shared_ptr<Mesh> Parse(const char *text, size_t length, jobs::JobSystem *job_system = nullptr);
+
+    /**
+     * Maps the file and parses it directly from the mapping. The parsed text is released while parsing,
+     * so the peak memory usage stays close to the size of the mesh.
+     *
+     * @param use_cache Load the mesh from its MeshCache next to the file when the cache is up to date,
+     *                  and write the cache after parsing otherwise. A cache that can't be written is skipped.
+     * @param verify_cache Check the whole cache against its checksum before using it, see MeshCache::Load.
+     * @return Null if the file can't be read or parsed.
+     */
+    static std::shared_ptr<Mesh> ParseFile(const std::string &path, jobs::JobSystem *job_system = nullptr,
+                                           bool use_cache = true, bool verify_cache = false);
 
     void SetText(const char *text, size_t length);
 
+    /**
+     * With a job system the text is split at line boundaries into chunks that are parsed in parallel,
+     * and then stitched together. The mesh is the same as the one parsed without a job system.
+     */
+    void SetJobSystem(jobs::JobSystem *job_system);
+
     bool Parse();
 
     std::shared_ptr<Mesh> GetMesh() const;
 
 private:
-    void NextLine();
+    enum Attribute {
+        kPosition,
+        kTextureCoordinate,
+        kNormal,
+        kAttributesCount
+    };
+
+    enum SubMeshField {
+        kObject,
+        kGroup,
+        kMaterial
+    };
+
+    // Indices of an attribute, one per face corner.
+    struct IndexStream {
+        // Positive indices are final. The ones at relative_indices came from negative indices,
+        // and are relative to the first element of the chunk until the chunks are stitched.
+        std::vector<uint32_t> indices;
+        std::vector<size_t> relative_indices;
+
+        // Largest final index.
+        uint32_t max_index = 0;
+    };
+
+    // Object, group or material statement, which starts a new sub-mesh.
+    struct SubMeshChange {
+        // Number of faces of the chunk before the statement.
+        size_t face;
+
+        SubMeshField field;
+        std::string_view name;
+    };
+
+    // Face element with the indices as written, zero for the missing ones.
+    struct Corner {
+        int64_t indices[kAttributesCount];
+    };
+
+    // Part of the text and the data parsed from it.
+    struct Chunk {
+        std::string_view text;
+
+        std::vector<Mesh::Vertex> vertices;
+        std::vector<Vector2> texture_coordinates;
+        std::vector<Vector3> normals;
+
+        IndexStream streams[kAttributesCount];
+        size_t faces_count = 0;
+
+        std::vector<SubMeshChange> sub_mesh_changes;
 
-    void Next();
+        // Corners of the face being parsed, reused between the faces.
+        std::vector<Corner> corners;
 
-    bool EndReached() const;
+        bool failed = false;
+    };
 
-    char Peek(int offset) const;
+    void SplitIntoChunks();
 
-    char Current() const;
+    void ParseChunk(Chunk *chunk) const;
 
-    void SkipSpaces();
+    static bool ParseLine(std::string_view line, Chunk *chunk);
 
-    void ResetCursor();
+    static bool ParseVertex(std::string_view line, Chunk *chunk);
 
-    uint32_t CountVertices();
+    static bool ParseTextureCoordinate(std::string_view line, Chunk *chunk);
 
-    std::string ReadWord();
+    static bool ParseNormal(std::string_view line, Chunk *chunk);
+
+    static bool ParseFace(std::string_view line, Chunk *chunk);
+
+    static void AddCorner(const Corner &corner, Chunk *chunk);
+
+    // Number of elements of the attribute in the chunk.
+    static size_t GetAttributeCount(const Chunk &chunk, Attribute attribute);
+
+    /**
+     * Resolves the relative indices of the chunks and concatenates them into the mesh.
+     * Fails if an index is out of range.
+     */
+    bool StitchChunks(Mesh *mesh);
+
+    bool StitchAttribute(Attribute attribute, std::vector<uint32_t> *indices);
+
+    // Concatenates the elements of the chunks, releasing them.
+    template<typename Element>
+    std::vector<Element> ConcatenateElements(std::vector<Element> Chunk::*elements);
+
+    std::vector<Mesh::SubMesh> BuildSubMeshes() const;
+
+    // Calls the function for every chunk, in parallel if there is a job system.
+    template<typename Function>
+    void ForEachChunk(Function function);
+
+private:
+    // Size of the chunks the text is split into when parsing in parallel.
+    static constexpr size_t kChunkSize = 4 * 1024 * 1024;
+
+    // Amount of parsed text after which the pages of a mapped file are released.
+    static constexpr size_t kDiscardInterval = 8 * 1024 * 1024;
 
 private:
-    const char *text_;
-    const char *end_;
+    std::string_view text_;
+
+    // Mapping of the text, when parsing a file.
+    io::MappedFile *mapped_file_ = nullptr;
 
-    const char *cursor_;
+    jobs::JobSystem *job_system_ = nullptr;
 
 private:
+    std::vector<Chunk> chunks_;
+
     std::shared_ptr<Mesh> mesh_;
-};
\ No newline at end of file
+};
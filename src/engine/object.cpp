@@ -14,8 +14,8 @@ Object::Object() {
 }
 
 void Object::SetWorldPosition(const Vector3 &position) {
-    if (attached_to_)
-        position_ = position - attached_to_->GetWorldPosition();
+    if (attached_world_)
+        position_ = position - GetAttachedPosition();
     else
         position_ = position;
 }
@@ -25,8 +25,8 @@ void Object::Move(const Vector3 &offset) {
 }
 
 Vector3 Object::GetWorldPosition() const {
-    if (attached_to_)
-        return attached_to_->GetWorldPosition() + position_;
+    if (attached_world_)
+        return GetAttachedPosition() + position_;
 
     return position_;
 }
@@ -63,26 +63,30 @@ Matrix4 Object::GetModelMatrix() const {
     return matrix::Translate(position_) * rotation_matrix_;
 }
 
-void Object::AttachTo(const std::shared_ptr<Object> &object) {
-    assert(object.get() != this);
+void Object::AttachTo(const std::shared_ptr<const World> &world, World::ObjectHandle object) {
+    assert(world->IsAlive(object));
 
-    position_ = GetWorldPosition() - object->GetWorldPosition();
+    position_ = GetWorldPosition() - world->GetPosition(object);
 
-    if (attached_to_)
-        position_ -= attached_to_->GetWorldPosition();
-
-    attached_to_ = object;
+    attached_world_ = world;
+    attached_object_ = object;
 }
 
 void Object::Detach() {
-    assert(attached_to_);
+    assert(attached_world_);
+
+    position_ += GetAttachedPosition();
 
-    position_ += attached_to_->GetWorldPosition();
-    attached_to_ = nullptr;
+    attached_world_ = nullptr;
+    attached_object_ = World::ObjectHandle();
 }
 
 bool Object::IsAttached() const {
-    return attached_to_ != nullptr;
+    return attached_world_ != nullptr;
+}
+
+Vector3 Object::GetAttachedPosition() const {
+    return attached_world_->GetPosition(attached_object_);
 }
 
 void Object::UpdateRotationMatrix() {
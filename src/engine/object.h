@@ -2,6 +2,7 @@
 
 #include <memory>
 
+#include "world.h"
 #include "math/vector.h"
 #include "math/matrix.h"
 
@@ -28,14 +29,19 @@ public:
     Matrix4 GetModelMatrix() const;
 
 public:
-    void AttachTo(const std::shared_ptr<Object> &object);
+    // Makes the position relative to an object of the world, which must stay alive while attached.
+    void AttachTo(const std::shared_ptr<const World> &world, World::ObjectHandle object);
 
     void Detach();
 
     bool IsAttached() const;
 
 private:
-    std::shared_ptr<Object> attached_to_;
+    Vector3 GetAttachedPosition() const;
+
+private:
+    std::shared_ptr<const World> attached_world_;
+    World::ObjectHandle attached_object_;
 
 private:
     void UpdateRotationMatrix();
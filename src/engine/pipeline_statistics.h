@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstdint>
+
+// Work done by a frame at every stage of the pipeline, like the pipeline statistics queries of GPUs.
+struct PipelineStatistics {
+    // Objects of the world, and the ones that were not drawn: rejected by the frustum, or hidden or without a mesh.
+    uint64_t objects_visited = 0;
+    uint64_t objects_culled = 0;
+    uint64_t objects_skipped = 0;
+
+    // Faces of the drawn objects.
+    uint64_t faces_in = 0;
+
+    // Faces rejected by the cull mode, by their clusters or one by one.
+    uint64_t faces_culled = 0;
+
+    // Faces with all the vertices outside of the same frustum plane.
+    uint64_t faces_outside = 0;
+
+    // Faces crossing the frustum planes, and the ones among them that nothing was left of.
+    uint64_t faces_clipped = 0;
+    uint64_t faces_clipped_away = 0;
+
+    // Triangles the clipped faces were split into.
+    uint64_t triangles_generated = 0;
+
+    // Primitives passed to the renderer, including the debug ones, and the draw calls they took.
+    uint64_t triangles_submitted = 0;
+    uint64_t lines_submitted = 0;
+    uint64_t draw_calls = 0;
+
+    PipelineStatistics &operator+=(const PipelineStatistics &other) {
+        objects_visited += other.objects_visited;
+        objects_culled += other.objects_culled;
+        objects_skipped += other.objects_skipped;
+        faces_in += other.faces_in;
+        faces_culled += other.faces_culled;
+        faces_outside += other.faces_outside;
+        faces_clipped += other.faces_clipped;
+        faces_clipped_away += other.faces_clipped_away;
+        triangles_generated += other.triangles_generated;
+        triangles_submitted += other.triangles_submitted;
+        lines_submitted += other.lines_submitted;
+        draw_calls += other.draw_calls;
+
+        return *this;
+    }
+};
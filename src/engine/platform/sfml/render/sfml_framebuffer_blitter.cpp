@@ -0,0 +1,27 @@
+#include <cassert>
+
+#include "sfml_framebuffer_blitter.h"
+
+using render::SFMLFramebufferBlitter;
+
+static_assert(sizeof(Color) == 4, "Color must be laid out as RGBA8 to be uploaded directly");
+
+void SFMLFramebufferBlitter::Blit(const SoftwareRenderer &renderer, sf::RenderTarget *render_target) {
+    assert(render_target != nullptr);
+
+    const sf::Vector2u size(renderer.GetWidth(), renderer.GetHeight());
+    if (size.x == 0 || size.y == 0)
+        return;
+
+    if (texture_.getSize() != size) {
+        const bool created = texture_.create(size.x, size.y);
+        assert(created && "Unable to create framebuffer texture.");
+        (void) created;
+
+        sprite_.setTexture(texture_, true);
+    }
+
+    texture_.update(reinterpret_cast<const sf::Uint8 *>(renderer.GetColorBuffer()));
+
+    render_target->draw(sprite_);
+}
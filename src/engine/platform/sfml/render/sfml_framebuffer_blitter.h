@@ -0,0 +1,19 @@
+#pragma once
+
+#include <SFML/Graphics.hpp>
+
+#include "../../../render/software_renderer.h"
+
+namespace render {
+
+    // Copies the color buffer of the software renderer to an SFML render target.
+    class SFMLFramebufferBlitter {
+    public:
+        void Blit(const SoftwareRenderer &renderer, sf::RenderTarget *render_target);
+
+    private:
+        sf::Texture texture_;
+        sf::Sprite sprite_;
+    };
+
+}
@@ -34,13 +34,18 @@ void SFMLRenderer::Draw(uint32_t vertex_count, uint32_t first_vertex) {
     else
         assert(false);
 
-    sf::VertexArray vertices(sfml_primitive_type, vertex_count);
+    vertices_.setPrimitiveType(sfml_primitive_type);
+    vertices_.resize(vertex_count);
 
-    for (size_t vertex_idx = first_vertex; vertex_idx < vertex_count; vertex_idx++) {
-        const Vertex &vertex = buffer_[vertex_idx];
-        vertices[vertex_idx] = sf::Vertex{sf::Vector2f(vertex.position[0], vertex.position[1]),
-                                          ColorToSfmlColor(vertex.color)};
+    for (size_t i = 0; i < vertex_count; i++) {
+        const Vertex &vertex = buffer_[first_vertex + i];
+        vertices_[i] = sf::Vertex{sf::Vector2f(vertex.position[0], vertex.position[1]),
+                                  ColorToSfmlColor(vertex.color)};
     }
 
-    render_target_->draw(vertices);
-}
\ No newline at end of file
+    render_target_->draw(vertices_);
+}
+
+void SFMLRenderer::Flush() {
+    // Every batch is drawn to the render target as soon as it is submitted.
+}
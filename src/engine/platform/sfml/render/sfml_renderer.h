@@ -14,6 +14,8 @@ namespace render {
 
         void Draw(uint32_t vertex_count, uint32_t first_vertex) override;
 
+        void Flush() override;
+
     private:
         sf::RenderTarget *render_target_ = nullptr;
 
@@ -21,6 +23,10 @@ namespace render {
         const Vertex *buffer_ = nullptr;
         uint32_t vertices_count_ = 0;
         PrimitiveTopology primitive_topology_;
+
+    private:
+        // Reused between draws to avoid reallocating the vertices.
+        sf::VertexArray vertices_;
     };
 
-}
\ No newline at end of file
+}
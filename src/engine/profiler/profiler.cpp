@@ -0,0 +1,322 @@
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <mutex>
+
+#include "profiler.h"
+
+std::atomic<bool> profiler::detail::enabled{false};
+
+namespace {
+
+    using Clock = std::chrono::steady_clock;
+
+    struct Event {
+        const char *name;
+        int64_t begin_ns;
+        int64_t end_ns;
+        uint32_t depth;
+    };
+
+    // Each thread records its scopes in its own buffer, so the scopes don't need a lock.
+    struct ThreadEvents {
+        uint32_t id;
+        std::vector<Event> events;
+
+        // Indices of the events of the scopes that haven't ended yet.
+        std::vector<size_t> open_scopes;
+    };
+
+    struct Stage {
+        const char *name;
+        int32_t parent;
+        uint32_t depth;
+
+        double frame_ms;
+
+        // Ring buffer of the totals of the last frames.
+        std::array<double, profiler::kHistoryFramesCount> history_ms;
+    };
+
+    struct CapturedEvent {
+        Event event;
+        uint32_t thread;
+    };
+
+    struct State {
+        const Clock::time_point epoch = Clock::now();
+
+        // Guards the list of the threads and the capture.
+        std::mutex mutex;
+        std::vector<std::unique_ptr<ThreadEvents>> threads;
+
+        ThreadEvents *frame_thread = nullptr;
+        bool frame_active = false;
+
+        std::vector<Stage> stages;
+        size_t history_index = 0;
+        size_t history_frames_count = 0;
+
+        uint32_t capture_frames_left = 0;
+        uint32_t captured_frames_count = 0;
+        std::vector<CapturedEvent> captured_events;
+    };
+
+    State &GetState() {
+        static State state;
+        return state;
+    }
+
+    int64_t Now() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - GetState().epoch).count();
+    }
+
+    ThreadEvents &GetThreadEvents() {
+        thread_local ThreadEvents *thread_events = nullptr;
+
+        if (!thread_events) {
+            State &state = GetState();
+            std::lock_guard<std::mutex> lock(state.mutex);
+
+            auto events = std::make_unique<ThreadEvents>();
+            events->id = static_cast<uint32_t>(state.threads.size());
+
+            thread_events = events.get();
+            state.threads.push_back(std::move(events));
+        }
+
+        return *thread_events;
+    }
+
+    int32_t FindOrAddStage(State *state, const char *name, int32_t parent, uint32_t depth) {
+        for (size_t i = 0; i < state->stages.size(); i++) {
+            const Stage &stage = state->stages[i];
+
+            if (stage.parent == parent && std::strcmp(stage.name, name) == 0)
+                return static_cast<int32_t>(i);
+        }
+
+        state->stages.push_back(Stage{name, parent, depth, 0, {}});
+
+        return static_cast<int32_t>(state->stages.size() - 1);
+    }
+
+    // Adds the scopes of the frame thread to the totals of their stages.
+    void AccumulateStages(State *state, const std::vector<Event> &events) {
+        // Stages of the enclosing scopes, by depth.
+        std::vector<int32_t> parents;
+
+        for (const Event &event : events) {
+            const int32_t parent = event.depth == 0 ? -1 : parents[event.depth - 1];
+            const int32_t stage = FindOrAddStage(state, event.name, parent, event.depth);
+
+            state->stages[stage].frame_ms += static_cast<double>(event.end_ns - event.begin_ns) / 1e6;
+
+            parents.resize(event.depth + 1);
+            parents[event.depth] = stage;
+        }
+
+        for (Stage &stage : state->stages) {
+            stage.history_ms[state->history_index] = stage.frame_ms;
+            stage.frame_ms = 0;
+        }
+
+        state->history_index = (state->history_index + 1) % profiler::kHistoryFramesCount;
+        state->history_frames_count = std::min(state->history_frames_count + 1, profiler::kHistoryFramesCount);
+    }
+
+    void AppendStageStatistics(const State &state, int32_t parent, std::vector<profiler::StageStatistics> *result) {
+        for (size_t i = 0; i < state.stages.size(); i++) {
+            const Stage &stage = state.stages[i];
+            if (stage.parent != parent)
+                continue;
+
+            const size_t last_index = (state.history_index + profiler::kHistoryFramesCount - 1) %
+                                      profiler::kHistoryFramesCount;
+
+            double total_ms = 0;
+            double max_ms = 0;
+
+            for (size_t frame = 0; frame < state.history_frames_count; frame++) {
+                total_ms += stage.history_ms[frame];
+                max_ms = std::max(max_ms, stage.history_ms[frame]);
+            }
+
+            result->push_back(profiler::StageStatistics{
+                    stage.name,
+                    stage.depth,
+                    stage.history_ms[last_index],
+                    total_ms / static_cast<double>(std::max<size_t>(state.history_frames_count, 1)),
+                    max_ms
+            });
+
+            AppendStageStatistics(state, static_cast<int32_t>(i), result);
+        }
+    }
+
+    void WriteJsonString(FILE *file, const char *string) {
+        std::fputc('"', file);
+
+        for (const char *c = string; *c != '\0'; c++) {
+            if (*c == '"' || *c == '\\')
+                std::fputc('\\', file);
+            std::fputc(*c, file);
+        }
+
+        std::fputc('"', file);
+    }
+
+}
+
+void profiler::SetEnabled(bool enabled) {
+    detail::enabled.store(enabled, std::memory_order_relaxed);
+}
+
+bool profiler::IsEnabled() {
+    return detail::enabled.load(std::memory_order_relaxed);
+}
+
+void profiler::BeginFrame() {
+    State &state = GetState();
+    assert(!state.frame_active && "EndFrame wasn't called");
+
+    if (!IsEnabled())
+        return;
+
+    state.frame_thread = &GetThreadEvents();
+    state.frame_active = true;
+
+    detail::BeginScope("Frame");
+}
+
+void profiler::EndFrame() {
+    State &state = GetState();
+
+    const bool frame_active = state.frame_active;
+
+    if (frame_active) {
+        assert(state.frame_thread == &GetThreadEvents() && "The frame must end on the thread it began on");
+
+        detail::EndScope();
+        state.frame_active = false;
+
+        AccumulateStages(&state, state.frame_thread->events);
+    }
+
+    std::lock_guard<std::mutex> lock(state.mutex);
+
+    // Only the frames that began with the profiler enabled are captured.
+    const bool capture = frame_active && state.capture_frames_left > 0;
+
+    if (capture) {
+        state.capture_frames_left--;
+        state.captured_frames_count++;
+    }
+
+    for (const std::unique_ptr<ThreadEvents> &thread : state.threads) {
+        assert(thread->open_scopes.empty() && "A thread is in a scope at the end of the frame");
+
+        if (capture) {
+            for (const Event &event : thread->events)
+                state.captured_events.push_back(CapturedEvent{event, thread->id});
+        }
+
+        thread->events.clear();
+    }
+}
+
+std::vector<profiler::StageStatistics> profiler::GetStageStatistics() {
+    std::vector<StageStatistics> result;
+    AppendStageStatistics(GetState(), -1, &result);
+
+    return result;
+}
+
+void profiler::StartCapture(uint32_t frames_count) {
+    State &state = GetState();
+    std::lock_guard<std::mutex> lock(state.mutex);
+
+    state.capture_frames_left = frames_count;
+    state.captured_frames_count = 0;
+    state.captured_events.clear();
+}
+
+bool profiler::IsCapturing() {
+    State &state = GetState();
+    std::lock_guard<std::mutex> lock(state.mutex);
+
+    return state.capture_frames_left > 0;
+}
+
+uint32_t profiler::GetCapturedFramesCount() {
+    State &state = GetState();
+    std::lock_guard<std::mutex> lock(state.mutex);
+
+    return state.captured_frames_count;
+}
+
+bool profiler::WriteChromeTrace(const std::string &path) {
+    State &state = GetState();
+    std::lock_guard<std::mutex> lock(state.mutex);
+
+    FILE *file = std::fopen(path.c_str(), "w");
+    if (!file)
+        return false;
+
+    std::fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+
+    bool first = true;
+
+    // Complete events, with the times in microseconds.
+    for (const CapturedEvent &captured : state.captured_events) {
+        const Event &event = captured.event;
+
+        std::fprintf(file, "%s{\"name\":", first ? "" : ",\n");
+        WriteJsonString(file, event.name);
+        std::fprintf(file, ",\"ph\":\"X\",\"pid\":0,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}", captured.thread,
+                     static_cast<double>(event.begin_ns) / 1e3,
+                     static_cast<double>(event.end_ns - event.begin_ns) / 1e3);
+
+        first = false;
+    }
+
+    for (const std::unique_ptr<ThreadEvents> &thread : state.threads) {
+        std::fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":%u,", first ? "" : ",\n",
+                     thread->id);
+
+        if (thread.get() == state.frame_thread)
+            std::fprintf(file, "\"args\":{\"name\":\"Frame thread\"}}");
+        else
+            std::fprintf(file, "\"args\":{\"name\":\"Thread %u\"}}", thread->id);
+
+        first = false;
+    }
+
+    std::fprintf(file, "\n]}\n");
+
+    const bool success = std::ferror(file) == 0;
+    std::fclose(file);
+
+    return success;
+}
+
+void profiler::detail::BeginScope(const char *name) {
+    ThreadEvents &thread = GetThreadEvents();
+
+    const auto depth = static_cast<uint32_t>(thread.open_scopes.size());
+
+    thread.open_scopes.push_back(thread.events.size());
+    thread.events.push_back(Event{name, Now(), 0, depth});
+}
+
+void profiler::detail::EndScope() {
+    ThreadEvents &thread = GetThreadEvents();
+    assert(!thread.open_scopes.empty());
+
+    thread.events[thread.open_scopes.back()].end_ns = Now();
+    thread.open_scopes.pop_back();
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * Frame profiler. Scopes measure the stages of a frame, on any thread:
+ *
+ *     PROFILE_SCOPE("Transform");
+ *
+ * The scopes of the thread that calls BeginFrame and EndFrame form the per-stage breakdown, averaged over the last
+ * frames. The scopes of all the threads of captured frames can be written as a Chrome trace, to be opened in
+ * chrome://tracing or Perfetto.
+ *
+ * A disabled profiler costs a relaxed atomic load per scope.
+ */
+namespace profiler {
+
+    void SetEnabled(bool enabled);
+
+    bool IsEnabled();
+
+    // The frame thread calls them around each frame. No thread may be in a scope at EndFrame, e.g. the jobs started
+    // in the frame must have finished, because EndFrame reads the events of all the threads without a lock.
+    void BeginFrame();
+
+    void EndFrame();
+
+    struct StageStatistics {
+        const char *name;
+
+        // Nesting level, zero for the frame.
+        uint32_t depth;
+
+        // Total time of the stage in a frame. A stage may run multiple times per frame, e.g. once per object.
+        double last_ms;
+        double average_ms;
+        double max_ms;
+    };
+
+    // Number of frames the averages are computed over.
+    constexpr size_t kHistoryFramesCount = 120;
+
+    // Stages seen by the frame thread, each followed by its nested stages. Called by the frame thread.
+    std::vector<StageStatistics> GetStageStatistics();
+
+    // Records all the scopes of the next frames the profiler is enabled for. A capture in progress is discarded.
+    void StartCapture(uint32_t frames_count);
+
+    bool IsCapturing();
+
+    // Frames recorded by the last capture, complete or not.
+    uint32_t GetCapturedFramesCount();
+
+    /**
+     * Writes the captured frames in the Chrome trace event format.
+     *
+     * @return False if the file can't be written.
+     */
+    bool WriteChromeTrace(const std::string &path);
+
+    namespace detail {
+        extern std::atomic<bool> enabled;
+
+        // The name must outlive the profiler, e.g. be a string literal.
+        void BeginScope(const char *name);
+
+        void EndScope();
+    }
+
+    class ScopedTimer {
+    public:
+        explicit ScopedTimer(const char *name) : active_(detail::enabled.load(std::memory_order_relaxed)) {
+            if (active_)
+                detail::BeginScope(name);
+        }
+
+        ~ScopedTimer() {
+            if (active_)
+                detail::EndScope();
+        }
+
+        ScopedTimer(const ScopedTimer &) = delete;
+
+        ScopedTimer &operator=(const ScopedTimer &) = delete;
+
+    private:
+        // The scope ends even if the profiler is disabled inside of it.
+        const bool active_;
+    };
+
+}
+
+#define PROFILE_SCOPE_CONCAT_IMPL(a, b) a##b
+#define PROFILE_SCOPE_CONCAT(a, b) PROFILE_SCOPE_CONCAT_IMPL(a, b)
+
+#define PROFILE_SCOPE(name) profiler::ScopedTimer PROFILE_SCOPE_CONCAT(profile_scope_, __LINE__)(name)
@@ -0,0 +1,72 @@
+#include <cstdio>
+#include <vector>
+
+#include "image_io.h"
+
+bool render::WritePPM(const std::string &path, uint32_t width, uint32_t height, const Color *pixels) {
+    FILE *file = std::fopen(path.c_str(), "wb");
+    if (!file)
+        return false;
+
+    std::fprintf(file, "P6\n%u %u\n255\n", width, height);
+
+    std::vector<uint8_t> row(static_cast<size_t>(width) * 3);
+
+    for (uint32_t y = 0; y < height; y++) {
+        const Color *row_pixels = pixels + static_cast<size_t>(y) * width;
+
+        for (uint32_t x = 0; x < width; x++) {
+            row[x * 3 + 0] = row_pixels[x].r;
+            row[x * 3 + 1] = row_pixels[x].g;
+            row[x * 3 + 2] = row_pixels[x].b;
+        }
+
+        std::fwrite(row.data(), 1, row.size(), file);
+    }
+
+    const bool success = std::ferror(file) == 0;
+    std::fclose(file);
+
+    return success;
+}
+
+bool render::ReadPPM(const std::string &path, uint32_t *width, uint32_t *height, std::vector<Color> *pixels) {
+    FILE *file = std::fopen(path.c_str(), "rb");
+    if (!file)
+        return false;
+
+    unsigned file_width = 0;
+    unsigned file_height = 0;
+    unsigned max_value = 0;
+
+    // The header is followed by a single whitespace character.
+    const bool header_read = std::fscanf(file, "P6 %u %u %u", &file_width, &file_height, &max_value) == 3 &&
+                             std::fgetc(file) != EOF;
+
+    if (!header_read || max_value != 255 || file_width == 0 || file_height == 0) {
+        std::fclose(file);
+        return false;
+    }
+
+    std::vector<uint8_t> row(static_cast<size_t>(file_width) * 3);
+    pixels->resize(static_cast<size_t>(file_width) * file_height);
+
+    for (uint32_t y = 0; y < file_height; y++) {
+        if (std::fread(row.data(), 1, row.size(), file) != row.size()) {
+            std::fclose(file);
+            return false;
+        }
+
+        Color *row_pixels = pixels->data() + static_cast<size_t>(y) * file_width;
+
+        for (uint32_t x = 0; x < file_width; x++)
+            row_pixels[x] = Color::RGBA(row[x * 3 + 0], row[x * 3 + 1], row[x * 3 + 2]);
+    }
+
+    std::fclose(file);
+
+    *width = file_width;
+    *height = file_height;
+
+    return true;
+}
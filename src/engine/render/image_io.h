@@ -0,0 +1,21 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "../math/color.h"
+
+namespace render {
+
+    // Writes the pixels as a binary PPM image. Alpha channel is dropped.
+    bool WritePPM(const std::string &path, uint32_t width, uint32_t height, const Color *pixels);
+
+    /**
+     * Reads a binary PPM image with 8 bits per channel, like the ones written by WritePPM. Alpha is set to opaque.
+     *
+     * @return False if the file can't be read or is not such an image.
+     */
+    bool ReadPPM(const std::string &path, uint32_t *width, uint32_t *height, std::vector<Color> *pixels);
+
+}
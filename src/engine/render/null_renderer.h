@@ -0,0 +1,30 @@
+#pragma once
+
+#include "renderer.h"
+
+namespace render {
+
+    /**
+     * Renderer that discards the primitives, so that the cost of Engine::Draw can be measured without rasterization.
+     * It only counts the vertices it was asked to draw.
+     */
+    class NullRenderer : public Renderer {
+    public:
+        void BindVertexBuffer(const Vertex * /*buffer*/, uint32_t /*count*/, PrimitiveTopology /*topology*/) override {}
+
+        void Draw(uint32_t vertex_count, uint32_t /*first_vertex*/) override {
+            vertices_count_ += vertex_count;
+        }
+
+        void Flush() override {}
+
+    public:
+        uint64_t GetVerticesCount() const {
+            return vertices_count_;
+        }
+
+    private:
+        uint64_t vertices_count_ = 0;
+    };
+
+}
@@ -13,7 +13,12 @@ namespace render {
     };
 
     struct Vertex {
+        // Position in screen space, in pixels.
         Vector2 position;
+
+        // Normalized device depth in range [0, 1], where zero is the near plane.
+        float depth;
+
         Color color;
     };
 
@@ -24,6 +29,12 @@ namespace render {
         virtual void BindVertexBuffer(const Vertex *buffer, uint32_t count, PrimitiveTopology topology) = 0;
 
         virtual void Draw(uint32_t vertex_count, uint32_t first_vertex) = 0;
+
+        /**
+         * Submits all the pending draws to the render target.
+         * Must be called once all the primitives of the frame have been drawn.
+         */
+        virtual void Flush() = 0;
     };
 
-}
\ No newline at end of file
+}
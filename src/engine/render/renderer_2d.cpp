@@ -1,37 +1,73 @@
 #include "renderer_2d.h"
 
+using render::PrimitiveBatch;
 using render::Renderer2D;
 
-Renderer2D::Renderer2D(Renderer *renderer) : renderer_(renderer) {
+static render::Vertex MakeVertex(const Vector3 &point, const Color &color) {
+    return render::Vertex{point.AsVec2(), point[2], color};
+}
+
+void PrimitiveBatch::DrawLine(const Vector3 &p1, const Vector3 &p2, const Color &color) {
+    lines_.push_back(MakeVertex(p1, color));
+    lines_.push_back(MakeVertex(p2, color));
+}
+
+void PrimitiveBatch::DrawTriangle(const Vector3 &p1, const Vector3 &p2, const Vector3 &p3, const Color &color) {
+    triangles_.push_back(MakeVertex(p1, color));
+    triangles_.push_back(MakeVertex(p2, color));
+    triangles_.push_back(MakeVertex(p3, color));
+}
+
+void PrimitiveBatch::DrawTriangle(const Vector3 &p1, const Vector3 &p2, const Vector3 &p3,
+                                  const Color &c1, const Color &c2, const Color &c3) {
+    triangles_.push_back(MakeVertex(p1, c1));
+    triangles_.push_back(MakeVertex(p2, c2));
+    triangles_.push_back(MakeVertex(p3, c3));
+}
+
+void PrimitiveBatch::Append(const PrimitiveBatch &batch) {
+    lines_.insert(lines_.end(), batch.lines_.begin(), batch.lines_.end());
+    triangles_.insert(triangles_.end(), batch.triangles_.begin(), batch.triangles_.end());
+}
+
+void PrimitiveBatch::Clear() {
+    lines_.clear();
+    triangles_.clear();
 }
 
-void Renderer2D::DrawLine(const Vector2 &p1, const Vector2 &p2, const Color &color) {
-    Vertex vertices[2];
+Renderer2D::Renderer2D(Renderer *renderer) : renderer_(renderer) {
+}
 
-    vertices[0].position = p1;
-    vertices[0].color = color;
+void Renderer2D::Flush() {
+    FlushStream(triangles_, PrimitiveTopology::kTriangles);
+    FlushStream(lines_, PrimitiveTopology::kLines);
 
-    vertices[1].position = p2;
-    vertices[1].color = color;
+    renderer_->Flush();
+}
 
-    renderer_->BindVertexBuffer(vertices, 2, PrimitiveTopology::kLines);
+const Renderer2D::Statistics &Renderer2D::GetStatistics() const {
+    return statistics_;
+}
 
-    renderer_->Draw(2, 0);
+void Renderer2D::ResetStatistics() {
+    statistics_ = Statistics();
 }
 
-void Renderer2D::DrawTriangle(const Vector2 &p1, const Vector2 &p2, const Vector2 &p3, const Color &color) {
-    Vertex vertices[3];
+void Renderer2D::FlushStream(std::vector<Vertex> &stream, PrimitiveTopology topology) {
+    if (stream.empty())
+        return;
 
-    vertices[0].position = p1;
-    vertices[0].color = color;
+    const auto vertex_count = static_cast<uint32_t>(stream.size());
 
-    vertices[1].position = p2;
-    vertices[1].color = color;
+    renderer_->BindVertexBuffer(stream.data(), vertex_count, topology);
+    renderer_->Draw(vertex_count, 0);
 
-    vertices[2].position = p3;
-    vertices[2].color = color;
+    if (topology == PrimitiveTopology::kTriangles)
+        statistics_.triangles += vertex_count / 3;
+    else
+        statistics_.lines += vertex_count / 2;
 
-    renderer_->BindVertexBuffer(vertices, 3, PrimitiveTopology::kTriangles);
+    statistics_.draw_calls++;
 
-    renderer_->Draw(3, 0);
-}
\ No newline at end of file
+    stream.clear();
+}
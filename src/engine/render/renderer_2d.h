@@ -1,19 +1,63 @@
 #pragma once
 
+#include <vector>
+
 #include "renderer.h"
 
 namespace render {
 
-    class Renderer2D {
+    // Primitives in screen space, collected into per-topology vertex streams.
+    class PrimitiveBatch {
+    public:
+        // The points are given in screen space, with the depth stored in the Z component.
+        void DrawLine(const Vector3 &p1, const Vector3 &p2, const Color &color);
+
+        void DrawTriangle(const Vector3 &p1, const Vector3 &p2, const Vector3 &p3, const Color &color);
+
+        // The colors of the corners are interpolated over the triangle.
+        void DrawTriangle(const Vector3 &p1, const Vector3 &p2, const Vector3 &p3,
+                          const Color &c1, const Color &c2, const Color &c3);
+
+        // Appends the primitives of the batch after the primitives of the same topology.
+        void Append(const PrimitiveBatch &batch);
+
+        // Keeps the capacity, so the streams are not reallocated every frame.
+        void Clear();
+
+    protected:
+        std::vector<Vertex> lines_;
+        std::vector<Vertex> triangles_;
+    };
+
+    // Collects primitives and submits them to a renderer in batches.
+    class Renderer2D : public PrimitiveBatch {
     public:
         explicit Renderer2D(Renderer *renderer);
 
-        void DrawLine(const Vector2 &p1, const Vector2 &p2, const Color &color);
+        /**
+         * Submits the collected primitives to the renderer and clears the streams.
+         * Triangles are submitted before lines, so that outlines are drawn on top of the faces.
+         */
+        void Flush();
+
+        struct Statistics {
+            uint64_t triangles = 0;
+            uint64_t lines = 0;
+            uint64_t draw_calls = 0;
+        };
+
+        // Primitives and draw calls submitted to the renderer since the last reset.
+        const Statistics &GetStatistics() const;
 
-        void DrawTriangle(const Vector2 &p1, const Vector2 &p2, const Vector2 &p3, const Color &color);
+        void ResetStatistics();
+
+    private:
+        void FlushStream(std::vector<Vertex> &stream, PrimitiveTopology topology);
 
     private:
         Renderer *renderer_;
+
+        Statistics statistics_;
     };
 
-}
\ No newline at end of file
+}
@@ -0,0 +1,466 @@
+#include <cassert>
+#include <algorithm>
+#include <cmath>
+
+#include "software_renderer.h"
+#include "../profiler/profiler.h"
+
+using render::SoftwareRenderer;
+
+// Vertex positions are snapped to a fixed point grid with 4 bits of subpixel precision,
+// which makes the edge functions exact.
+static constexpr int64_t kSubpixelBits = 4;
+static constexpr int64_t kSubpixelScale = 1 << kSubpixelBits;
+static constexpr int64_t kHalfPixel = kSubpixelScale / 2;
+
+// Lines are drawn slightly in front of the faces they outline, so they don't fight with them.
+static constexpr float kLineDepthBias = 0.00001f;
+
+namespace {
+    // Edge function of the directed edge A->B: E(p) = (Bx - Ax) * (Py - Ay) - (By - Ay) * (Px - Ax).
+    // It's positive for the points that lie inside a triangle with positive area.
+    struct Edge {
+        int64_t a; // Step along X
+        int64_t b; // Step along Y
+        int64_t c;
+        int64_t bias;
+
+        Edge() = default;
+
+        Edge(int64_t ax, int64_t ay, int64_t bx, int64_t by) {
+            a = ay - by;
+            b = bx - ax;
+            c = -(a * ax + b * ay);
+
+            // Top-left fill rule: the pixels lying exactly on an edge shared by two triangles
+            // belong to only one of them.
+            const bool is_owner = a > 0 || (a == 0 && b < 0);
+            bias = is_owner ? 0 : -1;
+        }
+
+        int64_t Evaluate(int64_t x, int64_t y) const {
+            return a * x + b * y + c + bias;
+        }
+    };
+}
+
+// Triangle set up for rasterization, with the winding made counterclockwise.
+struct SoftwareRenderer::Triangle {
+    Edge edges[3];
+
+    // Bounding box in pixels, clamped to the framebuffer.
+    Rect bounds;
+
+    // Depth plane equation, in pixels.
+    float origin_x;
+    float origin_y;
+    float origin_depth;
+    float depth_dx;
+    float depth_dy;
+
+    bool flat;
+    float inverse_area;
+    Color colors[3];
+};
+
+SoftwareRenderer::SoftwareRenderer() = default;
+
+SoftwareRenderer::~SoftwareRenderer() = default;
+
+void SoftwareRenderer::SetJobSystem(const std::shared_ptr<jobs::JobSystem> &job_system) {
+    job_system_ = job_system;
+}
+
+void SoftwareRenderer::Resize(uint32_t width, uint32_t height) {
+    assert(primitives_.empty() && "Resize must not be called before Flush");
+
+    width_ = width;
+    height_ = height;
+
+    color_buffer_.resize(static_cast<size_t>(width) * height);
+    depth_buffer_.resize(static_cast<size_t>(width) * height);
+
+    bins_x_ = (width + kBinSize - 1) / kBinSize;
+    bins_y_ = (height + kBinSize - 1) / kBinSize;
+    bins_.assign(static_cast<size_t>(bins_x_) * bins_y_, std::vector<uint32_t>());
+}
+
+void SoftwareRenderer::Clear(const Color &color, float depth) {
+    assert(primitives_.empty() && "Clear must not be called before Flush");
+
+    PROFILE_SCOPE("Clear");
+
+    std::fill(color_buffer_.begin(), color_buffer_.end(), color);
+    std::fill(depth_buffer_.begin(), depth_buffer_.end(), depth);
+}
+
+void SoftwareRenderer::BindVertexBuffer(const Vertex *buffer, uint32_t count, PrimitiveTopology topology) {
+    buffer_ = buffer;
+    vertices_count_ = count;
+    primitive_topology_ = topology;
+}
+
+void SoftwareRenderer::Draw(uint32_t vertex_count, uint32_t first_vertex) {
+    assert(buffer_ != nullptr);
+    assert(first_vertex + vertex_count <= vertices_count_);
+
+    const Vertex *vertices = buffer_ + first_vertex;
+
+    if (primitive_topology_ == kLines) {
+        for (uint32_t i = 0; i + 1 < vertex_count; i += 2)
+            SetupLine(vertices[i], vertices[i + 1]);
+    } else if (primitive_topology_ == kTriangles) {
+        for (uint32_t i = 0; i + 2 < vertex_count; i += 3)
+            SetupTriangle(vertices[i], vertices[i + 1], vertices[i + 2]);
+    } else
+        assert(false);
+}
+
+void SoftwareRenderer::Flush() {
+    if (primitives_.empty())
+        return;
+
+    PROFILE_SCOPE("Rasterize");
+
+    // The bins don't overlap, so they can be rasterized concurrently.
+    const auto rasterize_bins = [this](size_t begin, size_t end) {
+        PROFILE_SCOPE("Bins");
+
+        for (size_t bin = begin; bin < end; bin++)
+            RasterizeBin(static_cast<uint32_t>(bin));
+    };
+
+    if (job_system_)
+        job_system_->ParallelFor(bins_.size(), 1, rasterize_bins);
+    else
+        rasterize_bins(0, bins_.size());
+
+    for (std::vector<uint32_t> &bin : bins_)
+        bin.clear();
+
+    triangles_.clear();
+    lines_.clear();
+    primitives_.clear();
+}
+
+uint32_t SoftwareRenderer::GetWidth() const {
+    return width_;
+}
+
+uint32_t SoftwareRenderer::GetHeight() const {
+    return height_;
+}
+
+const Color *SoftwareRenderer::GetColorBuffer() const {
+    assert(primitives_.empty() && "The primitives are not flushed");
+    return color_buffer_.data();
+}
+
+const float *SoftwareRenderer::GetDepthBuffer() const {
+    assert(primitives_.empty() && "The primitives are not flushed");
+    return depth_buffer_.data();
+}
+
+static Color BlendColors(const Color &source, const Color &destination) {
+    const uint32_t alpha = source.a;
+    const uint32_t inverse_alpha = 255 - alpha;
+
+    return Color(static_cast<uint8_t>((source.r * alpha + destination.r * inverse_alpha) / 255),
+                 static_cast<uint8_t>((source.g * alpha + destination.g * inverse_alpha) / 255),
+                 static_cast<uint8_t>((source.b * alpha + destination.b * inverse_alpha) / 255),
+                 static_cast<uint8_t>(alpha + destination.a * inverse_alpha / 255));
+}
+
+static inline bool IsSameColor(const Color &lhs, const Color &rhs) {
+    return lhs.r == rhs.r && lhs.g == rhs.g && lhs.b == rhs.b && lhs.a == rhs.a;
+}
+
+void SoftwareRenderer::WritePixel(int32_t x, int32_t y, float depth, const Color &color) {
+    const size_t index = static_cast<size_t>(y) * width_ + x;
+
+    if (depth > depth_buffer_[index])
+        return;
+
+    depth_buffer_[index] = depth;
+
+    if (color.a == 255)
+        color_buffer_[index] = color;
+    else
+        color_buffer_[index] = BlendColors(color, color_buffer_[index]);
+}
+
+void SoftwareRenderer::SetupTriangle(const Vertex &v0, const Vertex &v1, const Vertex &v2) {
+    if (width_ == 0 || height_ == 0)
+        return;
+
+    const Vertex *vertices[3] = {&v0, &v1, &v2};
+
+    int64_t x[3];
+    int64_t y[3];
+
+    for (int i = 0; i < 3; i++) {
+        x[i] = std::llround(vertices[i]->position[0] * kSubpixelScale);
+        y[i] = std::llround(vertices[i]->position[1] * kSubpixelScale);
+    }
+
+    int64_t area = (x[1] - x[0]) * (y[2] - y[0]) - (y[1] - y[0]) * (x[2] - x[0]);
+    if (area == 0)
+        return; // Degenerate triangle.
+
+    if (area < 0) {
+        // No face culling is done here, so make the winding consistent.
+        std::swap(vertices[1], vertices[2]);
+        std::swap(x[1], x[2]);
+        std::swap(y[1], y[2]);
+        area = -area;
+    }
+
+    Triangle triangle;
+
+    triangle.bounds.min_x = std::max<int64_t>(std::min({x[0], x[1], x[2]}) >> kSubpixelBits, 0);
+    triangle.bounds.max_x = std::min<int64_t>(std::max({x[0], x[1], x[2]}) >> kSubpixelBits, width_ - 1);
+    triangle.bounds.min_y = std::max<int64_t>(std::min({y[0], y[1], y[2]}) >> kSubpixelBits, 0);
+    triangle.bounds.max_y = std::min<int64_t>(std::max({y[0], y[1], y[2]}) >> kSubpixelBits, height_ - 1);
+
+    if (triangle.bounds.min_x > triangle.bounds.max_x || triangle.bounds.min_y > triangle.bounds.max_y)
+        return;
+
+    triangle.edges[0] = Edge(x[1], y[1], x[2], y[2]);
+    triangle.edges[1] = Edge(x[2], y[2], x[0], y[0]);
+    triangle.edges[2] = Edge(x[0], y[0], x[1], y[1]);
+
+    triangle.origin_x = static_cast<float>(x[0]) / kSubpixelScale;
+    triangle.origin_y = static_cast<float>(y[0]) / kSubpixelScale;
+    triangle.origin_depth = vertices[0]->depth;
+
+    const float dx1 = static_cast<float>(x[1] - x[0]) / kSubpixelScale;
+    const float dy1 = static_cast<float>(y[1] - y[0]) / kSubpixelScale;
+    const float dx2 = static_cast<float>(x[2] - x[0]) / kSubpixelScale;
+    const float dy2 = static_cast<float>(y[2] - y[0]) / kSubpixelScale;
+    const float dz1 = vertices[1]->depth - vertices[0]->depth;
+    const float dz2 = vertices[2]->depth - vertices[0]->depth;
+
+    const float determinant = dx1 * dy2 - dx2 * dy1;
+    triangle.depth_dx = (dz1 * dy2 - dz2 * dy1) / determinant;
+    triangle.depth_dy = (dz2 * dx1 - dz1 * dx2) / determinant;
+
+    triangle.flat = IsSameColor(vertices[0]->color, vertices[1]->color) &&
+                    IsSameColor(vertices[0]->color, vertices[2]->color);
+    triangle.inverse_area = 1.f / static_cast<float>(area);
+
+    for (int i = 0; i < 3; i++)
+        triangle.colors[i] = vertices[i]->color;
+
+    primitives_.push_back(Primitive{kTriangles, static_cast<uint32_t>(triangles_.size())});
+    triangles_.push_back(triangle);
+
+    AddToBins(triangle.bounds);
+}
+
+void SoftwareRenderer::SetupLine(const Vertex &v0, const Vertex &v1) {
+    if (width_ == 0 || height_ == 0)
+        return;
+
+    const int64_t x0 = static_cast<int64_t>(std::floor(v0.position[0]));
+    const int64_t y0 = static_cast<int64_t>(std::floor(v0.position[1]));
+    const int64_t x1 = static_cast<int64_t>(std::floor(v1.position[0]));
+    const int64_t y1 = static_cast<int64_t>(std::floor(v1.position[1]));
+
+    const Rect bounds{std::max<int64_t>(std::min(x0, x1), 0),
+                      std::max<int64_t>(std::min(y0, y1), 0),
+                      std::min<int64_t>(std::max(x0, x1), width_ - 1),
+                      std::min<int64_t>(std::max(y0, y1), height_ - 1)};
+
+    if (bounds.min_x > bounds.max_x || bounds.min_y > bounds.max_y)
+        return;
+
+    primitives_.push_back(Primitive{kLines, static_cast<uint32_t>(lines_.size())});
+    lines_.push_back(Line{v0, v1});
+
+    AddToBins(bounds);
+}
+
+void SoftwareRenderer::AddToBins(const Rect &bounds) {
+    const auto primitive = static_cast<uint32_t>(primitives_.size() - 1);
+
+    const int64_t first_bin_x = bounds.min_x / kBinSize;
+    const int64_t last_bin_x = bounds.max_x / kBinSize;
+    const int64_t first_bin_y = bounds.min_y / kBinSize;
+    const int64_t last_bin_y = bounds.max_y / kBinSize;
+
+    for (int64_t bin_y = first_bin_y; bin_y <= last_bin_y; bin_y++)
+        for (int64_t bin_x = first_bin_x; bin_x <= last_bin_x; bin_x++)
+            bins_[bin_y * bins_x_ + bin_x].push_back(primitive);
+}
+
+void SoftwareRenderer::RasterizeBin(uint32_t bin) {
+    const std::vector<uint32_t> &bin_primitives = bins_[bin];
+    if (bin_primitives.empty())
+        return;
+
+    const int64_t bin_x = (bin % bins_x_) * kBinSize;
+    const int64_t bin_y = (bin / bins_x_) * kBinSize;
+
+    const Rect bin_rect{bin_x,
+                        bin_y,
+                        std::min<int64_t>(bin_x + kBinSize - 1, width_ - 1),
+                        std::min<int64_t>(bin_y + kBinSize - 1, height_ - 1)};
+
+    for (uint32_t primitive_index : bin_primitives) {
+        const Primitive &primitive = primitives_[primitive_index];
+
+        if (primitive.topology == kTriangles)
+            RasterizeTriangle(triangles_[primitive.index], bin_rect);
+        else
+            RasterizeLine(lines_[primitive.index], bin_rect);
+    }
+}
+
+void SoftwareRenderer::RasterizeTriangle(const Triangle &triangle, const Rect &bin_rect) {
+    const Edge *edges = triangle.edges;
+
+    // The bins are aligned to the tiles, so the tiles and the pixel values are the same as without the binning.
+    const int64_t min_x = std::max(triangle.bounds.min_x, bin_rect.min_x);
+    const int64_t max_x = std::min(triangle.bounds.max_x, bin_rect.max_x);
+    const int64_t min_y = std::max(triangle.bounds.min_y, bin_rect.min_y);
+    const int64_t max_y = std::min(triangle.bounds.max_y, bin_rect.max_y);
+
+    const float origin_x = triangle.origin_x;
+    const float origin_y = triangle.origin_y;
+    const float origin_depth = triangle.origin_depth;
+    const float depth_dx = triangle.depth_dx;
+    const float depth_dy = triangle.depth_dy;
+
+    const bool flat = triangle.flat;
+    const float inverse_area = triangle.inverse_area;
+
+    const auto shade = [&](const int64_t w[3]) -> Color {
+        if (flat)
+            return triangle.colors[0];
+
+        // Edge i is opposite to vertex i, so its value is the barycentric weight of that vertex.
+        const float b0 = static_cast<float>(w[0] - edges[0].bias) * inverse_area;
+        const float b1 = static_cast<float>(w[1] - edges[1].bias) * inverse_area;
+        const float b2 = static_cast<float>(w[2] - edges[2].bias) * inverse_area;
+
+        const auto channel = [&](uint8_t c0, uint8_t c1, uint8_t c2) {
+            const float value = b0 * static_cast<float>(c0) + b1 * static_cast<float>(c1) + b2 * static_cast<float>(c2);
+            return static_cast<uint8_t>(std::min(std::max(value, 0.f), 255.f));
+        };
+
+        const Color &c0 = triangle.colors[0];
+        const Color &c1 = triangle.colors[1];
+        const Color &c2 = triangle.colors[2];
+
+        return Color(channel(c0.r, c1.r, c2.r),
+                     channel(c0.g, c1.g, c2.g),
+                     channel(c0.b, c1.b, c2.b),
+                     channel(c0.a, c1.a, c2.a));
+    };
+
+    const auto rasterize_tile = [&](int64_t tile_min_x, int64_t tile_min_y,
+                                    int64_t tile_max_x, int64_t tile_max_y) {
+        // Sample points are the pixel centers.
+        const int64_t sample_x = (tile_min_x << kSubpixelBits) + kHalfPixel;
+        const int64_t sample_y = (tile_min_y << kSubpixelBits) + kHalfPixel;
+        const int64_t extent_x = (tile_max_x - tile_min_x) << kSubpixelBits;
+        const int64_t extent_y = (tile_max_y - tile_min_y) << kSubpixelBits;
+
+        // The edge functions are linear, so the tile corners bound their values over the whole tile.
+        bool fully_covered = true;
+
+        int64_t row_w[3];
+        for (int i = 0; i < 3; i++) {
+            const Edge &edge = edges[i];
+            row_w[i] = edge.Evaluate(sample_x, sample_y);
+
+            const int64_t dx = edge.a * extent_x;
+            const int64_t dy = edge.b * extent_y;
+            const int64_t max_value = row_w[i] + std::max<int64_t>(dx, 0) + std::max<int64_t>(dy, 0);
+            const int64_t min_value = row_w[i] + std::min<int64_t>(dx, 0) + std::min<int64_t>(dy, 0);
+
+            if (max_value < 0)
+                return; // The whole tile is outside of the edge.
+
+            if (min_value < 0)
+                fully_covered = false;
+        }
+
+        for (int64_t py = tile_min_y; py <= tile_max_y; py++) {
+            int64_t w[3] = {row_w[0], row_w[1], row_w[2]};
+
+            float depth = origin_depth + depth_dx * (static_cast<float>(tile_min_x) + 0.5f - origin_x) +
+                          depth_dy * (static_cast<float>(py) + 0.5f - origin_y);
+
+            for (int64_t px = tile_min_x; px <= tile_max_x; px++) {
+                if (fully_covered || (w[0] >= 0 && w[1] >= 0 && w[2] >= 0))
+                    WritePixel(static_cast<int32_t>(px), static_cast<int32_t>(py), depth, shade(w));
+
+                for (int i = 0; i < 3; i++)
+                    w[i] += edges[i].a * kSubpixelScale;
+
+                depth += depth_dx;
+            }
+
+            for (int i = 0; i < 3; i++)
+                row_w[i] += edges[i].b * kSubpixelScale;
+        }
+    };
+
+    const int64_t first_tile_x = min_x - min_x % kTileSize;
+    const int64_t first_tile_y = min_y - min_y % kTileSize;
+
+    for (int64_t tile_y = first_tile_y; tile_y <= max_y; tile_y += kTileSize) {
+        for (int64_t tile_x = first_tile_x; tile_x <= max_x; tile_x += kTileSize) {
+            rasterize_tile(std::max(tile_x, min_x),
+                           std::max(tile_y, min_y),
+                           std::min(tile_x + kTileSize - 1, max_x),
+                           std::min(tile_y + kTileSize - 1, max_y));
+        }
+    }
+}
+
+void SoftwareRenderer::RasterizeLine(const Line &line, const Rect &bin_rect) {
+    const Vertex &v0 = line.v0;
+    const Vertex &v1 = line.v1;
+
+    // Bresenham's line algorithm. The whole line is walked in every bin, so the pixels are the same as without
+    // the binning, but only the pixels inside the bin are written.
+    int32_t x0 = static_cast<int32_t>(std::floor(v0.position[0]));
+    int32_t y0 = static_cast<int32_t>(std::floor(v0.position[1]));
+    const int32_t x1 = static_cast<int32_t>(std::floor(v1.position[0]));
+    const int32_t y1 = static_cast<int32_t>(std::floor(v1.position[1]));
+
+    const int32_t dx = std::abs(x1 - x0);
+    const int32_t dy = -std::abs(y1 - y0);
+    const int32_t step_x = x0 < x1 ? 1 : -1;
+    const int32_t step_y = y0 < y1 ? 1 : -1;
+
+    const int32_t steps = std::max(dx, -dy);
+    const float depth_step = steps > 0 ? (v1.depth - v0.depth) / static_cast<float>(steps) : 0.f;
+    float depth = v0.depth - kLineDepthBias;
+
+    int32_t error = dx + dy;
+
+    while (true) {
+        if (x0 >= bin_rect.min_x && y0 >= bin_rect.min_y && x0 <= bin_rect.max_x && y0 <= bin_rect.max_y)
+            WritePixel(x0, y0, depth, v0.color);
+
+        if (x0 == x1 && y0 == y1)
+            break;
+
+        const int32_t error2 = 2 * error;
+
+        if (error2 >= dy) {
+            error += dy;
+            x0 += step_x;
+        }
+
+        if (error2 <= dx) {
+            error += dx;
+            y0 += step_y;
+        }
+
+        depth += depth_step;
+    }
+}
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "renderer.h"
+#include "../jobs/job_system.h"
+
+namespace render {
+
+    /**
+     * Renderer that rasterizes the primitives on the CPU into a color and a depth buffer.
+     * It does not depend on any window, so it can be used offscreen.
+     *
+     * The drawn primitives are binned into screen bins and rasterized on Flush, one bin per job.
+     * Every bin keeps the primitives in their submission order, so the image doesn't depend on the number of threads.
+     */
+    class SoftwareRenderer : public Renderer {
+    public:
+        // Size of the square screen tiles the triangles are rasterized by, in pixels.
+        static constexpr int32_t kTileSize = 16;
+
+        // Size of the square screen bins the primitives are sorted into, in pixels. A multiple of the tile size.
+        static constexpr int32_t kBinSize = 4 * kTileSize;
+
+        SoftwareRenderer();
+
+        ~SoftwareRenderer() override;
+
+        // Without a job system, or with a single thread one, the bins are rasterized on the calling thread.
+        void SetJobSystem(const std::shared_ptr<jobs::JobSystem> &job_system);
+
+        void Resize(uint32_t width, uint32_t height);
+
+        // Must not be called while there are primitives waiting for Flush.
+        void Clear(const Color &color, float depth = 1.f);
+
+        void BindVertexBuffer(const Vertex *buffer, uint32_t count, PrimitiveTopology topology) override;
+
+        void Draw(uint32_t vertex_count, uint32_t first_vertex) override;
+
+        void Flush() override;
+
+    public:
+        uint32_t GetWidth() const;
+
+        uint32_t GetHeight() const;
+
+        // Row-major RGBA pixels, starting from the top left corner.
+        const Color *GetColorBuffer() const;
+
+        const float *GetDepthBuffer() const;
+
+    private:
+        struct Triangle;
+
+        struct Line {
+            Vertex v0;
+            Vertex v1;
+        };
+
+        // Primitive in the submission order. The index points into the triangles or the lines.
+        struct Primitive {
+            PrimitiveTopology topology;
+            uint32_t index;
+        };
+
+        // Pixel rectangle, inclusive.
+        struct Rect {
+            int64_t min_x;
+            int64_t min_y;
+            int64_t max_x;
+            int64_t max_y;
+        };
+
+        void SetupTriangle(const Vertex &v0, const Vertex &v1, const Vertex &v2);
+
+        void SetupLine(const Vertex &v0, const Vertex &v1);
+
+        void AddToBins(const Rect &bounds);
+
+        void RasterizeBin(uint32_t bin);
+
+        void RasterizeTriangle(const Triangle &triangle, const Rect &bin_rect);
+
+        void RasterizeLine(const Line &line, const Rect &bin_rect);
+
+        void WritePixel(int32_t x, int32_t y, float depth, const Color &color);
+
+    private:
+        uint32_t width_ = 0;
+        uint32_t height_ = 0;
+
+        std::vector<Color> color_buffer_;
+        std::vector<float> depth_buffer_;
+
+    private:
+        const Vertex *buffer_ = nullptr;
+        uint32_t vertices_count_ = 0;
+        PrimitiveTopology primitive_topology_;
+
+    private:
+        std::shared_ptr<jobs::JobSystem> job_system_;
+
+        uint32_t bins_x_ = 0;
+        uint32_t bins_y_ = 0;
+
+        std::vector<Triangle> triangles_;
+        std::vector<Line> lines_;
+        std::vector<Primitive> primitives_;
+
+        // Indices of the primitives overlapping every bin, in the submission order.
+        std::vector<std::vector<uint32_t>> bins_;
+    };
+
+}
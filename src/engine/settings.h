@@ -23,6 +23,24 @@ struct DebugSettings {
     TriangleSettings clipped_triangle;
 };
 
+enum class CullMode {
+    kNone,
+    kBack,
+    kFront
+};
+
+enum class Shading {
+    kFlat,
+    kSmooth
+};
+
 struct Settings {
     DebugSettings debug;
+
+    // Faces facing away from the camera (kBack) or towards it (kFront) are not drawn.
+    CullMode cull_mode;
+
+    // kSmooth shades the corners of the faces with the vertex normals of the mesh, and interpolates the colors.
+    // Meshes without normals are shaded flat.
+    Shading shading;
 };
\ No newline at end of file
@@ -1,4 +1,5 @@
 #include "view.h"
+#include "math/simd/simd.h"
 
 void View::SetViewPort(const ViewPort &viewport) {
     viewport_ = viewport;
@@ -31,7 +32,7 @@ void View::UpdateMatrices() {
 
     data_.view_matrix = camera_->ComputeViewMatrix();
     data_.projection_matrix = camera_->ComputeProjectionMatrix();
-    data_.view_projection_matrix = data_.projection_matrix * data_.view_matrix;
+    simd::GetKernels().multiply_matrices(data_.projection_matrix, data_.view_matrix, &data_.view_projection_matrix);
 }
 
 const ViewData &View::GetViewData() const {
@@ -1,17 +1,426 @@
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
 #include "world.h"
+#include "math/angle.h"
+#include "math/matrix_transform.h"
 
 World::World() {
     world_matrix_.SetIdentity();
 }
 
-void World::AddObject(const std::shared_ptr<RigidBody> &object) {
-    objects_.emplace_back(object);
+World::ObjectHandle World::AddObject(const ObjectDescription &description) {
+    uint32_t slot;
+
+    if (free_slot_ != kInvalidSlot) {
+        slot = free_slot_;
+        free_slot_ = slots_[slot].index;
+    } else {
+        slot = static_cast<uint32_t>(slots_.size());
+        slots_.push_back(Slot{0, 0});
+    }
+
+    const auto index = static_cast<uint32_t>(handles_.size());
+    slots_[slot].index = index;
+
+    const ObjectHandle handle{slot, slots_[slot].generation};
+
+    handles_.push_back(handle);
+    positions_.push_back(description.position);
+    rotation_angles_.push_back(Vector2::Zero());
+    rotation_velocities_.push_back(description.rotation_velocity);
+    rotation_matrices_.emplace_back();
+    meshes_.push_back(description.mesh);
+    colors_.push_back(description.color);
+    visible_.push_back(description.visible);
+
+    SetRotation(index, description.rotation_angles);
+
+    const BoundingBox bounds = ComputeBounds(index);
+
+    leaves_.push_back(bvh_.Insert(bounds, slot));
+    bounds_.push_back(bounds);
+    moved_.push_back(false);
+
+    return handle;
 }
 
-const std::list<std::shared_ptr<RigidBody>> &World::ListObjects() const {
-    return objects_;
+void World::RemoveObject(ObjectHandle object) {
+    const uint32_t index = GetIndex(object);
+    const auto last = static_cast<uint32_t>(handles_.size() - 1);
+
+    bvh_.Remove(leaves_[index]);
+
+    // The last object takes the place of the removed one.
+    const auto move_last = [&](auto &components) {
+        components[index] = std::move(components[last]);
+        components.pop_back();
+    };
+
+    slots_[handles_[last].slot].index = index;
+
+    move_last(handles_);
+    move_last(positions_);
+    move_last(rotation_angles_);
+    move_last(rotation_velocities_);
+    move_last(rotation_matrices_);
+    move_last(meshes_);
+    move_last(colors_);
+    move_last(visible_);
+    move_last(leaves_);
+    move_last(bounds_);
+    move_last(moved_);
+
+    // The generation invalidates the handles of the removed object.
+    Slot &slot = slots_[object.slot];
+    slot.generation++;
+    slot.index = free_slot_;
+    free_slot_ = object.slot;
+}
+
+bool World::IsAlive(ObjectHandle object) const {
+    // Removing an object advances the generation of its slot, so a free slot doesn't match any handle.
+    return object.slot < slots_.size() && slots_[object.slot].generation == object.generation;
+}
+
+size_t World::GetObjectsCount() const {
+    return handles_.size();
+}
+
+memory::ArrayView<World::ObjectHandle> World::ListObjects() const {
+    return handles_;
 }
 
 Matrix4 World::GetWorldMatrix() const {
     return world_matrix_;
-}
\ No newline at end of file
+}
+
+void World::SetMesh(ObjectHandle object, const std::shared_ptr<Mesh> &mesh) {
+    meshes_[GetIndex(object)] = mesh;
+}
+
+const std::shared_ptr<Mesh> &World::GetMesh(ObjectHandle object) const {
+    return meshes_[GetIndex(object)];
+}
+
+void World::SetPosition(ObjectHandle object, const Vector3 &position) {
+    positions_[GetIndex(object)] = position;
+}
+
+Vector3 World::GetPosition(ObjectHandle object) const {
+    return positions_[GetIndex(object)];
+}
+
+void World::SetRotationAngles(ObjectHandle object, const Vector2 &rotation_angles) {
+    SetRotation(GetIndex(object), rotation_angles);
+}
+
+Vector2 World::GetRotationAngles(ObjectHandle object) const {
+    return rotation_angles_[GetIndex(object)];
+}
+
+void World::SetRotationVelocity(ObjectHandle object, const Vector2 &rotation_velocity) {
+    rotation_velocities_[GetIndex(object)] = rotation_velocity;
+}
+
+Vector2 World::GetRotationVelocity(ObjectHandle object) const {
+    return rotation_velocities_[GetIndex(object)];
+}
+
+void World::SetColor(ObjectHandle object, const Color &color) {
+    colors_[GetIndex(object)] = color;
+}
+
+Color World::GetColor(ObjectHandle object) const {
+    return colors_[GetIndex(object)];
+}
+
+void World::SetVisible(ObjectHandle object, bool visible) {
+    visible_[GetIndex(object)] = visible;
+}
+
+bool World::IsVisible(ObjectHandle object) const {
+    return visible_[GetIndex(object)];
+}
+
+Matrix4 World::GetModelMatrix(ObjectHandle object) const {
+    return ComputeModelMatrix(GetIndex(object));
+}
+
+void World::UpdateRotations(float ts, jobs::JobSystem *job_system) {
+    const auto update_rotations = [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++)
+            SetRotation(i, rotation_angles_[i] + rotation_velocities_[i] * ts);
+    };
+
+    constexpr size_t kBatchSize = 4096;
+
+    if (job_system)
+        job_system->ParallelFor(handles_.size(), kBatchSize, update_rotations);
+    else
+        update_rotations(0, handles_.size());
+}
+
+void World::UpdateBounds(jobs::JobSystem *job_system) {
+    const auto compute_bounds = [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            bounds_[i] = ComputeBounds(i);
+            moved_[i] = bvh_.NeedsUpdate(leaves_[i], bounds_[i]);
+        }
+    };
+
+    constexpr size_t kBatchSize = 1024;
+
+    if (job_system)
+        job_system->ParallelFor(handles_.size(), kBatchSize, compute_bounds);
+    else
+        compute_bounds(0, handles_.size());
+
+    // Only the objects that left their fat boxes change the hierarchy.
+    for (size_t i = 0; i < handles_.size(); i++) {
+        if (moved_[i])
+            bvh_.Update(leaves_[i], bounds_[i]);
+    }
+}
+
+void World::QueryFrustum(const Frustum &frustum, std::vector<FrustumQueryResult> *objects) const {
+    objects->clear();
+
+    // Indices of the objects, with the lowest bit telling whether the object is fully inside.
+    std::vector<uint32_t> &found = query_indices_;
+    found.clear();
+
+    bvh_.QueryFrustum(frustum, [&](uint32_t slot, bool fully_inside) {
+        found.push_back(slots_[slot].index << 1 | (fully_inside ? 1 : 0));
+    });
+
+    std::sort(found.begin(), found.end());
+
+    for (uint32_t value : found)
+        objects->push_back(FrustumQueryResult{handles_[value >> 1], (value & 1) != 0});
+}
+
+void World::QueryBox(const BoundingBox &box, std::vector<ObjectHandle> *objects) const {
+    objects->clear();
+
+    std::vector<uint32_t> &found = query_indices_;
+    found.clear();
+
+    bvh_.QueryBox(box, [&](uint32_t slot) {
+        const uint32_t index = slots_[slot].index;
+        const BoundingBox &bounds = bounds_[index];
+
+        for (int axis = 0; axis < 3; axis++) {
+            if (bounds.max[axis] < box.min[axis] || box.max[axis] < bounds.min[axis])
+                return;
+        }
+
+        found.push_back(index);
+    });
+
+    std::sort(found.begin(), found.end());
+
+    for (uint32_t index : found)
+        objects->push_back(handles_[index]);
+}
+
+void World::QuerySphere(const BoundingSphere &sphere, std::vector<ObjectHandle> *objects) const {
+    objects->clear();
+
+    const Vector3 radius(sphere.radius, sphere.radius, sphere.radius);
+    const BoundingBox box{sphere.center - radius, sphere.center + radius};
+
+    std::vector<uint32_t> &found = query_indices_;
+    found.clear();
+
+    bvh_.QueryBox(box, [&](uint32_t slot) {
+        const uint32_t index = slots_[slot].index;
+        const BoundingBox &bounds = bounds_[index];
+
+        // Distance from the center to the nearest point of the bounds.
+        float distance_squared = 0;
+
+        for (int axis = 0; axis < 3; axis++) {
+            const float nearest = std::clamp(sphere.center[axis], bounds.min[axis], bounds.max[axis]);
+            distance_squared += (sphere.center[axis] - nearest) * (sphere.center[axis] - nearest);
+        }
+
+        if (distance_squared <= sphere.radius * sphere.radius)
+            found.push_back(index);
+    });
+
+    std::sort(found.begin(), found.end());
+
+    for (uint32_t index : found)
+        objects->push_back(handles_[index]);
+}
+
+// Möller-Trumbore intersection. Returns the distance along the ray, or a negative value if the ray misses.
+static float IntersectTriangle(const Vector3 &origin, const Vector3 &direction,
+                               const Vector3 &p1, const Vector3 &p2, const Vector3 &p3) {
+    const Vector3 edge1 = p2 - p1;
+    const Vector3 edge2 = p3 - p1;
+
+    const Vector3 p = direction.Cross(edge2);
+    const float determinant = edge1.Dot(p);
+
+    if (determinant == 0)
+        return -1; // The ray is parallel to the triangle, or the triangle is degenerate.
+
+    const float inverse_determinant = 1 / determinant;
+
+    const Vector3 t = origin - p1;
+    const float u = t.Dot(p) * inverse_determinant;
+    if (u < 0 || u > 1)
+        return -1;
+
+    const Vector3 q = t.Cross(edge1);
+    const float v = direction.Dot(q) * inverse_determinant;
+    if (v < 0 || u + v > 1)
+        return -1;
+
+    return edge2.Dot(q) * inverse_determinant;
+}
+
+// Whether the ray hits the sphere within the distance.
+static bool IntersectSphere(const Vector3 &origin, const Vector3 &direction, float max_distance,
+                            const Vector3 &center, float radius) {
+    const Vector3 to_center = center - origin;
+
+    const float a = direction.Dot(direction);
+    const float b = to_center.Dot(direction);
+    const float c = to_center.Dot(to_center) - radius * radius;
+
+    const float discriminant = b * b - a * c;
+    if (discriminant < 0)
+        return false;
+
+    const float root = std::sqrt(discriminant);
+
+    return b + root >= 0 && b - root <= max_distance * a;
+}
+
+// Finds the nearest face of the mesh the ray hits within the distance. The ray is given in the object space.
+static bool RaycastMesh(const Mesh &mesh, const Vector3 &origin, const Vector3 &direction, float max_distance,
+                        float *distance, size_t *face) {
+    const memory::ArrayView<Mesh::Vertex> vertices = mesh.GetVertices();
+    const memory::ArrayView<Mesh::FaceCluster> clusters = mesh.GetFaceClusters();
+    const size_t faces_count = mesh.GetFacesCount();
+
+    bool found = false;
+
+    mesh.GetIndices().Visit([&](const auto *indices, size_t) {
+        for (size_t cluster = 0; cluster < clusters.size(); cluster++) {
+            if (!IntersectSphere(origin, direction, max_distance, clusters[cluster].center, clusters[cluster].radius))
+                continue;
+
+            const size_t first_face = cluster * Mesh::kClusterSize;
+            const size_t end_face = std::min(first_face + Mesh::kClusterSize, faces_count);
+
+            for (size_t i = first_face; i < end_face; i++) {
+                const float t = IntersectTriangle(origin, direction,
+                                                  vertices[indices[i * 3]].position,
+                                                  vertices[indices[i * 3 + 1]].position,
+                                                  vertices[indices[i * 3 + 2]].position);
+
+                if (t >= 0 && t <= max_distance) {
+                    max_distance = t;
+                    *distance = t;
+                    *face = i;
+                    found = true;
+                }
+            }
+        }
+    });
+
+    return found;
+}
+
+bool World::Raycast(const Vector3 &origin, const Vector3 &direction, float max_distance, RaycastHit *hit) const {
+    bool found = false;
+
+    bvh_.QueryRay(origin, direction, max_distance, [&](uint32_t slot, float distance) {
+        const uint32_t index = slots_[slot].index;
+
+        const std::shared_ptr<Mesh> &mesh = meshes_[index];
+        if (!visible_[index] || !mesh)
+            return distance;
+
+        // The model matrix is rigid, so the distances are the same in the object space.
+        const Matrix4 inverse_model_matrix = matrix::InvertRigid(ComputeModelMatrix(index));
+        const Vector3 object_origin = inverse_model_matrix * origin;
+        const Vector3 object_direction = (inverse_model_matrix * direction.AsVec4(0)).AsVec3();
+
+        float mesh_distance;
+        size_t face;
+
+        if (!RaycastMesh(*mesh, object_origin, object_direction, distance, &mesh_distance, &face))
+            return distance;
+
+        *hit = RaycastHit{handles_[index], mesh_distance, face};
+        found = true;
+
+        return mesh_distance;
+    });
+
+    return found;
+}
+
+uint32_t World::GetIndex(ObjectHandle object) const {
+    assert(IsAlive(object) && "The object was removed");
+
+    return slots_[object.slot].index;
+}
+
+void World::SetRotation(size_t index, const Vector2 &rotation_angles) {
+    // Strips the values of greater than 360 degrees magnitude, like Object.
+    const Vector2 angles(std::fmod(rotation_angles[0], Radians(360)), std::fmod(rotation_angles[1], Radians(360)));
+
+    rotation_angles_[index] = angles;
+
+    // Evaluated in the same order as Object, so the model matrices are the same.
+    rotation_matrices_[index] = matrix::RotateAroundX(angles[1]) * matrix::RotateAroundY(-angles[0]);
+}
+
+Matrix4 World::ComputeModelMatrix(size_t index) const {
+    // Translate(position) * rotation, without the product: the translation only fills the last column.
+    Matrix4 model_matrix = rotation_matrices_[index];
+    model_matrix.SetColumn(3, positions_[index]);
+
+    return model_matrix;
+}
+
+BoundingBox World::ComputeBounds(size_t index) const {
+    const std::shared_ptr<Mesh> &mesh = meshes_[index];
+    if (!mesh)
+        return BoundingBox{positions_[index], positions_[index]};
+
+    const Matrix4 model_matrix = ComputeModelMatrix(index);
+
+    const Mesh::Bounds &bounds = mesh->GetBounds();
+
+    // Box around the rotated box (Arvo's method).
+    const Vector3 center = model_matrix * bounds.box.GetCenter();
+    const Vector3 half_extents = bounds.box.GetHalfExtents();
+
+    Vector3 extents;
+    for (int row = 0; row < 3; row++) {
+        extents[row] = std::abs(model_matrix[row][0]) * half_extents.x +
+                       std::abs(model_matrix[row][1]) * half_extents.y +
+                       std::abs(model_matrix[row][2]) * half_extents.z;
+    }
+
+    // The sphere doesn't grow with the rotation, so the box is clamped to the box around it.
+    const Vector3 sphere_center = model_matrix * bounds.sphere.center;
+    const Vector3 radius(bounds.sphere.radius, bounds.sphere.radius, bounds.sphere.radius);
+
+    BoundingBox box;
+
+    for (int axis = 0; axis < 3; axis++) {
+        box.min[axis] = std::max(center[axis] - extents[axis], sphere_center[axis] - radius[axis]);
+        box.max[axis] = std::min(center[axis] + extents[axis], sphere_center[axis] + radius[axis]);
+    }
+
+    return box;
+}
@@ -1,23 +1,188 @@
 #pragma once
 
-#include <list>
+#include <cstdint>
 #include <memory>
+#include <vector>
 
-#include "rigid_body.h"
+#include "dynamic_bvh.h"
+#include "mesh.h"
+#include "jobs/job_system.h"
+#include "math/bounding_volumes.h"
+#include "math/color.h"
+#include "math/frustum.h"
 #include "math/matrix.h"
+#include "math/vector.h"
+#include "memory/array_view.h"
 
+/**
+ * Objects of the scene. Their state is stored by component in dense arrays, so the passes over all the objects
+ * stream through memory, and the objects are referred to by handles. Removing an object moves the last one
+ * into its place, so the arrays stay dense.
+ *
+ * A bounding volume hierarchy over the world space bounds of the objects serves the queries. The queries see
+ * the objects as they were at the last UpdateBounds; the engine updates them before every frame. Their results
+ * are listed in the storage order, so they don't depend on the shape of the hierarchy.
+ */
 class World {
 public:
+    // Stays valid until the object is removed. Handles of removed objects are detected, even if the slot is reused.
+    struct ObjectHandle {
+        uint32_t slot = kInvalidSlot;
+        uint32_t generation = 0;
+
+        bool operator==(const ObjectHandle &other) const {
+            return slot == other.slot && generation == other.generation;
+        }
+
+        bool operator!=(const ObjectHandle &other) const {
+            return !(*this == other);
+        }
+    };
+
+    struct ObjectDescription {
+        std::shared_ptr<Mesh> mesh;
+
+        Vector3 position = Vector3::Zero();
+
+        // Yaw and pitch, like Object.
+        Vector2 rotation_angles = Vector2::Zero();
+        Vector2 rotation_velocity = Vector2::Zero();
+
+        Color color = Color::White();
+        bool visible = true;
+    };
+
     World();
 
-    void AddObject(const std::shared_ptr<RigidBody> &object);
+    ObjectHandle AddObject(const ObjectDescription &description);
 
-    const std::list<std::shared_ptr<RigidBody>> &ListObjects() const;
+    void RemoveObject(ObjectHandle object);
+
+    bool IsAlive(ObjectHandle object) const;
+
+    size_t GetObjectsCount() const;
+
+    // Handles of the objects in the storage order.
+    memory::ArrayView<ObjectHandle> ListObjects() const;
 
     Matrix4 GetWorldMatrix() const;
 
+public:
+    // The objects must be alive.
+    void SetMesh(ObjectHandle object, const std::shared_ptr<Mesh> &mesh);
+
+    const std::shared_ptr<Mesh> &GetMesh(ObjectHandle object) const;
+
+    void SetPosition(ObjectHandle object, const Vector3 &position);
+
+    Vector3 GetPosition(ObjectHandle object) const;
+
+    void SetRotationAngles(ObjectHandle object, const Vector2 &rotation_angles);
+
+    Vector2 GetRotationAngles(ObjectHandle object) const;
+
+    void SetRotationVelocity(ObjectHandle object, const Vector2 &rotation_velocity);
+
+    Vector2 GetRotationVelocity(ObjectHandle object) const;
+
+    void SetColor(ObjectHandle object, const Color &color);
+
+    Color GetColor(ObjectHandle object) const;
+
+    void SetVisible(ObjectHandle object, bool visible);
+
+    bool IsVisible(ObjectHandle object) const;
+
+    // The same transform as Object::GetModelMatrix.
+    Matrix4 GetModelMatrix(ObjectHandle object) const;
+
+public:
+    // Advances the rotation angles of the objects by their velocities.
+    void UpdateRotations(float ts, jobs::JobSystem *job_system = nullptr);
+
+    // Recomputes the bounds of the objects from their meshes and transforms, and updates the hierarchy.
+    void UpdateBounds(jobs::JobSystem *job_system = nullptr);
+
+    struct FrustumQueryResult {
+        ObjectHandle object;
+
+        // The object doesn't need to be clipped.
+        bool fully_inside;
+    };
+
+    // Finds the objects that may intersect the frustum given in the world space.
+    // Like the other queries and Raycast, it reuses scratch buffers of the world, so they must not run concurrently.
+    void QueryFrustum(const Frustum &frustum, std::vector<FrustumQueryResult> *objects) const;
+
+    // Finds the objects whose bounds overlap the box.
+    void QueryBox(const BoundingBox &box, std::vector<ObjectHandle> *objects) const;
+
+    // Finds the objects whose bounds overlap the sphere.
+    void QuerySphere(const BoundingSphere &sphere, std::vector<ObjectHandle> *objects) const;
+
+    struct RaycastHit {
+        ObjectHandle object;
+
+        // Distance along the ray, in the units of its direction.
+        float distance;
+
+        size_t face;
+    };
+
+    /**
+     * Finds the nearest face of a visible object that the ray hits within the distance.
+     * Both sides of the faces are hit.
+     *
+     * @return False if the ray hits nothing.
+     */
+    bool Raycast(const Vector3 &origin, const Vector3 &direction, float max_distance, RaycastHit *hit) const;
+
+private:
+    static constexpr uint32_t kInvalidSlot = UINT32_MAX;
+
+    // Maps a handle to the index of the object in the dense arrays. Free slots are linked by their indices.
+    struct Slot {
+        uint32_t index;
+        uint32_t generation;
+    };
+
+    uint32_t GetIndex(ObjectHandle object) const;
+
+    void SetRotation(size_t index, const Vector2 &rotation_angles);
+
+    Matrix4 ComputeModelMatrix(size_t index) const;
+
+    BoundingBox ComputeBounds(size_t index) const;
+
 private:
     Matrix4 world_matrix_;
 
-    std::list<std::shared_ptr<RigidBody>> objects_;
-};
\ No newline at end of file
+    std::vector<Slot> slots_;
+    uint32_t free_slot_ = kInvalidSlot;
+
+    // Components, indexed by the dense index of the object.
+    std::vector<ObjectHandle> handles_;
+    std::vector<Vector3> positions_;
+    std::vector<Vector2> rotation_angles_;
+    std::vector<Vector2> rotation_velocities_;
+
+    // Rotations of the angles, recomputed only when the angles change.
+    std::vector<Matrix4> rotation_matrices_;
+    std::vector<std::shared_ptr<Mesh>> meshes_;
+    std::vector<Color> colors_;
+    std::vector<uint8_t> visible_;
+
+    // Leaves of the objects in the hierarchy, whose user data are the slots.
+    std::vector<int32_t> leaves_;
+
+    // World space bounds, tighter than the fat boxes of the leaves.
+    std::vector<BoundingBox> bounds_;
+
+    // Whether the bounds need the leaf to be reinserted.
+    std::vector<uint8_t> moved_;
+
+    DynamicBvh bvh_;
+
+    // Indices of the objects found by a query, sorted before they are returned.
+    mutable std::vector<uint32_t> query_indices_;
+};
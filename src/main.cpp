@@ -1,18 +1,20 @@
-#include <fstream>
 #include <cassert>
+#include <cstring>
 
 #include <SFML/Graphics.hpp>
 
 #include "engine/engine.h"
 
 #include "engine/platform/sfml/render/sfml_renderer.h"
+#include "engine/platform/sfml/render/sfml_framebuffer_blitter.h"
+#include "engine/render/software_renderer.h"
 
 #include "camera_controller.h"
 #include "menu.h"
 
 #include "engine/math/matrix_transform.h"
 #include "engine/obj_parser.h"
-#include "engine/rigid_body.h"
+#include "engine/profiler/profiler.h"
 
 static sf::Vector2i GetCenterPosition(sf::RenderWindow &window) {
     return sf::Vector2i(static_cast<int>(window.getSize().x / 2), static_cast<int>(window.getSize().y / 2));
@@ -26,26 +28,6 @@ static sf::Vector2i GetMouseMovement(sf::RenderWindow &window) {
     return sf::Mouse::getPosition(window) - GetCenterPosition(window);
 }
 
-std::unordered_map<std::string, CameraInfo> *cameras; // TODO: remove it
-
-// Used to read .obj file.
-std::string ReadFile(const char *filepath) {
-    std::ifstream file(filepath, std::ios::in | std::ios::ate);
-
-    if (!file.is_open())
-        return std::string();
-
-    std::streamsize file_size = file.tellg();
-    file.seekg(0);
-
-    std::string data(file_size, '\0');
-    file.read(&data[0], file_size);
-
-    file.close();
-
-    return data;
-}
-
 static const char dodecahedron_obj[] =
         "v  -0.57735  -0.57735  0.57735\n"
         "v  0.934172  0.356822  0\n"
@@ -121,14 +103,9 @@ std::unique_ptr<sf::RenderWindow> CreateWindow(const std::string &name, const sf
     return window;
 }
 
-std::unique_ptr<Engine> CreateEngine(sf::RenderWindow *window) {
+std::unique_ptr<Engine> CreateEngine(sf::RenderWindow *window, std::shared_ptr<render::Renderer> renderer) {
     auto engine = std::make_unique<Engine>();
 
-    auto sfml_renderer = std::make_shared<render::SFMLRenderer>();
-    sfml_renderer->SetRenderTarget(window);
-
-    std::shared_ptr<render::Renderer> renderer = sfml_renderer;
-
     ViewPort viewport(static_cast<float>(window->getSize().x),
                       static_cast<float>(window->getSize().y));
 
@@ -138,32 +115,55 @@ std::unique_ptr<Engine> CreateEngine(sf::RenderWindow *window) {
 }
 
 void InitializeObject(Engine *engine) {
-//        std::string obj_mesh_text = ReadFile("obj/dodecahedron.obj");
-//        assert(!obj_mesh_text.empty() && "Mesh .obj file not found.");
+//        std::shared_ptr<Mesh> mesh = ObjParser::ParseFile("obj/dodecahedron.obj");
 
     std::shared_ptr<Mesh> mesh = ObjParser::Parse(dodecahedron_obj, sizeof(dodecahedron_obj) - 1);
     assert(mesh && "Failed to parse mesh .obj file.");
 
     mesh->Transform(matrix::Scale(3.f));
 
-    auto obj = std::make_shared<RigidBody>();
-    obj->SetMesh(mesh);
-    obj->SetColor(Color(0xFF, 0xD3, 0xC9, 0xFF));
-    obj->SetWorldPosition(Vector3(10, 10, 10));
-    obj->SetRotationVelocity(Vector2(M_PI / 2, M_PI / 2));
+    World::ObjectDescription description;
+    description.mesh = mesh;
+    description.color = Color(0xFF, 0xD3, 0xC9, 0xFF);
+    description.position = Vector3(10, 10, 10);
+    description.rotation_velocity = Vector2(M_PI / 2, M_PI / 2);
 
-    engine->GetWorld()->AddObject(obj);
-    engine->GetActiveCamera()->AttachTo(obj);
+    const World::ObjectHandle object = engine->GetWorld()->AddObject(description);
+    engine->GetActiveCamera()->AttachTo(engine->GetWorld(), object);
 }
 
-int main() {
+int main(int argc, char **argv) {
+    bool use_software_renderer = false;
+
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--software-renderer") == 0)
+            use_software_renderer = true;
+    }
+
     std::unique_ptr<sf::RenderWindow> window = CreateWindow("Spinning dodecahedron", sf::VideoMode(1280, 720));
     if (!window) {
         printf("Unable to create window.\n");
         return 1;
     }
 
-    std::unique_ptr<Engine> engine = CreateEngine(window.get());
+    std::shared_ptr<render::Renderer> renderer;
+    std::shared_ptr<render::SoftwareRenderer> software_renderer;
+    render::SFMLFramebufferBlitter framebuffer_blitter;
+
+    if (use_software_renderer) {
+        software_renderer = std::make_shared<render::SoftwareRenderer>();
+        software_renderer->Resize(window->getSize().x, window->getSize().y);
+        renderer = software_renderer;
+    } else {
+        auto sfml_renderer = std::make_shared<render::SFMLRenderer>();
+        sfml_renderer->SetRenderTarget(window.get());
+        renderer = sfml_renderer;
+    }
+
+    std::unique_ptr<Engine> engine = CreateEngine(window.get(), renderer);
+
+    if (software_renderer)
+        software_renderer->SetJobSystem(engine->GetJobSystem());
     InitializeObject(engine.get());
 
     auto camera_controller = std::make_shared<CameraController>();
@@ -180,55 +180,82 @@ int main() {
     menu_data.cameras["main_camera"] = CameraInfo{
             .camera = engine->GetActiveCamera()
     };
-    cameras = &menu_data.cameras; // TODO: remove it
+    engine->SetDebugCameras(&menu_data.cameras);
 
     sf::Clock delta_clock;
 
     while (window->isOpen()) {
+        profiler::BeginFrame();
+
         sf::Time time_elapsed = delta_clock.restart();
 
-        sf::Event event;
-        while (window->pollEvent(event)) {
-            menu.ProcessEvent(event);
-
-            if (event.type == sf::Event::Closed)
-                window->close();
-            else if (event.type == sf::Event::KeyPressed) {
-                if (event.key.code == sf::Keyboard::Key::F2) {
-                    // Menu toggle
-                    menu.Toggle();
-                    window->setMouseCursorVisible(menu.IsActive());
-                    if (!menu.IsActive())
-                        SetMouseInCenter(*window);
-                } else if (event.key.code == sf::Keyboard::Key::Escape)
+        {
+            PROFILE_SCOPE("Events");
+
+            sf::Event event;
+            while (window->pollEvent(event)) {
+                menu.ProcessEvent(event);
+
+                if (event.type == sf::Event::Closed)
                     window->close();
-            } else if (!menu.IsActive()) {
-                if (event.type == sf::Event::MouseMoved) {
-                    sf::Vector2i mouse_position = sf::Mouse::getPosition(*window);
-                    sf::Vector2i center_position = GetCenterPosition(*window);
-                    if (mouse_position != center_position)
-                        sf::Mouse::setPosition(center_position, *window);
-
-                    sf::Vector2i mouse_movement = mouse_position - center_position;
-                    camera_controller->HandleMouseMovement(mouse_movement.x, mouse_movement.y);
-                } else if (event.type == sf::Event::MouseEntered) {
-                    SetMouseInCenter(*window);
+                else if (event.type == sf::Event::KeyPressed) {
+                    if (event.key.code == sf::Keyboard::Key::F2) {
+                        // Menu toggle
+                        menu.Toggle();
+                        window->setMouseCursorVisible(menu.IsActive());
+                        if (!menu.IsActive())
+                            SetMouseInCenter(*window);
+                    } else if (event.key.code == sf::Keyboard::Key::Escape)
+                        window->close();
+                } else if (!menu.IsActive()) {
+                    if (event.type == sf::Event::MouseMoved) {
+                        sf::Vector2i mouse_position = sf::Mouse::getPosition(*window);
+                        sf::Vector2i center_position = GetCenterPosition(*window);
+                        if (mouse_position != center_position)
+                            sf::Mouse::setPosition(center_position, *window);
+
+                        sf::Vector2i mouse_movement = mouse_position - center_position;
+                        camera_controller->HandleMouseMovement(mouse_movement.x, mouse_movement.y);
+                    } else if (event.type == sf::Event::MouseEntered) {
+                        SetMouseInCenter(*window);
+                    }
                 }
             }
         }
 
         // Update controllers
         engine->Update(time_elapsed.asSeconds());
-        menu.Update(time_elapsed);
+
+        {
+            PROFILE_SCOPE("ImGui");
+            menu.Update(time_elapsed);
+        }
 
         // Drawings
         window->clear(background_color);
-        engine->Draw();
 
-        menu.Draw(&menu_data);
-        menu.Render();
+        if (software_renderer) {
+            software_renderer->Clear(Color(background_color.r, background_color.g, background_color.b, 0xFF));
+            engine->Draw();
+
+            PROFILE_SCOPE("Blit");
+            framebuffer_blitter.Blit(*software_renderer, window.get());
+        } else
+            engine->Draw();
+
+        {
+            PROFILE_SCOPE("ImGui");
+
+            menu.Draw(&menu_data);
+            menu.Render();
+        }
+
+        {
+            PROFILE_SCOPE("Display");
+            window->display();
+        }
 
-        window->display();
+        profiler::EndFrame();
     }
 
     menu.Shutdown();
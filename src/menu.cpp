@@ -1,9 +1,13 @@
+#include <algorithm>
 #include <cassert>
+#include <cstdint>
+#include <string>
 
 #include <imgui.h>
 #include <imgui-SFML.h>
 
 #include "engine/engine.h"
+#include "engine/profiler/profiler.h"
 
 #include "menu.h"
 
@@ -79,6 +83,67 @@ static void DrawObjectProperties(Object *object) {
     ImGui::InputFloat3("Direction forward", &direction[0], "%.8f", ImGuiInputTextFlags_ReadOnly);
 }
 
+static void DrawProfiler() {
+    bool enabled = profiler::IsEnabled();
+    if (ImGui::Checkbox("Enabled", &enabled))
+        profiler::SetEnabled(enabled);
+
+    // Stages, with the times over the last frames
+    ImGui::Text("%-24s %8s %8s %8s", "Stage, ms", "Last", "Average", "Max");
+
+    for (const profiler::StageStatistics &stage : profiler::GetStageStatistics()) {
+        const int indent = static_cast<int>(stage.depth) * 2;
+
+        ImGui::Text("%*s%-*s %8.3f %8.3f %8.3f", indent, "", 24 - indent, stage.name,
+                    stage.last_ms, stage.average_ms, stage.max_ms);
+    }
+
+    // Capture
+    static int capture_frames_count = 60;
+    ImGui::InputInt("Frames to capture", &capture_frames_count);
+    capture_frames_count = std::max(capture_frames_count, 1);
+
+    static char trace_path[256] = "trace.json";
+    static std::string trace_status;
+
+    if (profiler::IsCapturing())
+        ImGui::Text("Capturing: %u frames", profiler::GetCapturedFramesCount());
+    else if (ImGui::Button("Capture")) {
+        profiler::SetEnabled(true);
+        profiler::StartCapture(static_cast<uint32_t>(capture_frames_count));
+        trace_status.clear();
+    }
+
+    ImGui::InputText("Trace file", trace_path, sizeof(trace_path));
+
+    if (!profiler::IsCapturing() && profiler::GetCapturedFramesCount() > 0 && ImGui::Button("Write Chrome trace")) {
+        const std::string path = trace_path;
+        trace_status = profiler::WriteChromeTrace(path) ? "Written " + path : "Unable to write " + path;
+    }
+
+    if (!trace_status.empty())
+        ImGui::TextUnformatted(trace_status.c_str());
+}
+
+static void DrawPipelineStatistics(const PipelineStatistics &statistics) {
+    const auto show = [](const char *name, uint64_t value) {
+        ImGui::Text("%-24s %10llu", name, static_cast<unsigned long long>(value));
+    };
+
+    show("Objects visited", statistics.objects_visited);
+    show("Objects culled", statistics.objects_culled);
+    show("Objects skipped", statistics.objects_skipped);
+    show("Faces in", statistics.faces_in);
+    show("Faces culled", statistics.faces_culled);
+    show("Faces outside", statistics.faces_outside);
+    show("Faces clipped", statistics.faces_clipped);
+    show("Faces clipped away", statistics.faces_clipped_away);
+    show("Triangles generated", statistics.triangles_generated);
+    show("Triangles submitted", statistics.triangles_submitted);
+    show("Lines submitted", statistics.lines_submitted);
+    show("Draw calls", statistics.draw_calls);
+}
+
 void Menu::Draw(DrawData *data) {
     if (!menu_active_)
         return;
@@ -96,6 +161,12 @@ void Menu::Draw(DrawData *data) {
 
     ImGui::ColorEdit3("Background color", data->window_background_color);
 
+    if (ImGui::CollapsingHeader("Profiler"))
+        DrawProfiler();
+
+    if (ImGui::CollapsingHeader("Pipeline statistics"))
+        DrawPipelineStatistics(data->engine->GetPipelineStatistics());
+
     if (ImGui::CollapsingHeader("Settings")) {
         const auto show_triangles_settings = [&](DebugSettings::TriangleSettings &triangle_settings) {
             ImGui::Checkbox("Show outlines", &triangle_settings.outlines.show);
@@ -112,6 +183,18 @@ void Menu::Draw(DrawData *data) {
 
         Settings *settings = data->engine->AccessSettings();
 
+        static const char *cull_modes[] = {"None", "Back", "Front"};
+
+        int cull_mode = static_cast<int>(settings->cull_mode);
+        if (ImGui::Combo("Cull faces", &cull_mode, cull_modes, IM_ARRAYSIZE(cull_modes)))
+            settings->cull_mode = static_cast<CullMode>(cull_mode);
+
+        static const char *shadings[] = {"Flat", "Smooth"};
+
+        int shading = static_cast<int>(settings->shading);
+        if (ImGui::Combo("Shading", &shading, shadings, IM_ARRAYSIZE(shadings)))
+            settings->shading = static_cast<Shading>(shading);
+
         // Temporarily doesn't work
 //        if (ImGui::TreeNode("Triangles")) {
 //            show_triangles_settings(settings->debug.triangle);
@@ -125,23 +208,34 @@ void Menu::Draw(DrawData *data) {
     }
 
     if (ImGui::CollapsingHeader("Objects")) {
-        const std::list<std::shared_ptr<RigidBody>> &bodies = data->engine->GetWorld()->ListObjects();
+        const std::shared_ptr<World> &world = data->engine->GetWorld();
 
-        for (const std::shared_ptr<RigidBody> &body : bodies) {
-            if (ImGui::TreeNode(body.get(), "body 0x%p", body.get())) {
-                bool visible = body->IsVisible();
+        for (const World::ObjectHandle object : world->ListObjects()) {
+            const void *id = reinterpret_cast<const void *>(static_cast<uintptr_t>(object.slot));
+
+            if (ImGui::TreeNode(id, "object %u", object.slot)) {
+                bool visible = world->IsVisible(object);
                 if (ImGui::Checkbox("Visible", &visible))
-                    body->SetVisible(visible);
+                    world->SetVisible(object, visible);
 
-                Color color = body->GetColor();
+                Color color = world->GetColor(object);
                 if (ImGui::ColorEdit4("Color", &color))
-                    body->SetColor(color);
+                    world->SetColor(object, color);
 
-                Vector2 rotation_velocity = body->GetRotationVelocity() * (180 / M_PI);
+                Vector2 rotation_velocity = world->GetRotationVelocity(object) * (180 / M_PI);
                 if (ImGui::DragFloat2("Rotation velocity", &rotation_velocity[0], 1, -180, 180))
-                    body->SetRotationVelocity(rotation_velocity * (M_PI / 180));
+                    world->SetRotationVelocity(object, rotation_velocity * (M_PI / 180));
+
+                // Position
+                Vector3 position = world->GetPosition(object);
+                if (ImGui::DragFloat3("World position", &position[0], 0.01))
+                    world->SetPosition(object, position);
+
+                // Rotation
+                Vector2 rotation_angles = world->GetRotationAngles(object) * Degree(1);
+                if (ImGui::DragFloat2("Rotation", &rotation_angles[0], 1, -360, 360))
+                    world->SetRotationAngles(object, rotation_angles * Radians(1));
 
-                DrawObjectProperties(body.get());
                 ImGui::TreePop();
             }
         }
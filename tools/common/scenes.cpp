@@ -0,0 +1,113 @@
+#include <cassert>
+#include <cmath>
+#include <cstdio>
+#include <memory>
+#include <random>
+
+#include "engine/obj_parser.h"
+#include "engine/math/angle.h"
+
+#include "scenes.h"
+
+std::string scenes::GenerateSphereObj(float radius, uint32_t stacks, uint32_t slices) {
+    std::string text;
+    char line[96];
+
+    text += "# Synthetic sphere\n";
+
+    std::snprintf(line, sizeof(line), "v 0 %.6f 0\n", radius);
+    text += line;
+
+    for (uint32_t stack = 1; stack < stacks; stack++) {
+        const double polar = M_PI * stack / stacks;
+
+        for (uint32_t slice = 0; slice < slices; slice++) {
+            const double azimuth = 2 * M_PI * slice / slices;
+
+            std::snprintf(line, sizeof(line), "v %.6f %.6f %.6f\n", radius * std::sin(polar) * std::cos(azimuth),
+                          radius * std::cos(polar), radius * std::sin(polar) * std::sin(azimuth));
+            text += line;
+        }
+    }
+
+    std::snprintf(line, sizeof(line), "v 0 %.6f 0\n", -radius);
+    text += line;
+
+    // One-based indices of the .obj format.
+    const uint32_t top = 1;
+    const uint32_t bottom = 2 + (stacks - 1) * slices;
+    const auto ring_vertex = [&](uint32_t stack, uint32_t slice) {
+        return 2 + (stack - 1) * slices + slice % slices;
+    };
+
+    const auto append_face = [&](uint32_t i1, uint32_t i2, uint32_t i3) {
+        std::snprintf(line, sizeof(line), "f %u %u %u\n", i1, i2, i3);
+        text += line;
+    };
+
+    for (uint32_t slice = 0; slice < slices; slice++) {
+        append_face(top, ring_vertex(1, slice + 1), ring_vertex(1, slice));
+        append_face(bottom, ring_vertex(stacks - 1, slice), ring_vertex(stacks - 1, slice + 1));
+    }
+
+    for (uint32_t stack = 1; stack + 1 < stacks; stack++) {
+        for (uint32_t slice = 0; slice < slices; slice++) {
+            append_face(ring_vertex(stack, slice), ring_vertex(stack, slice + 1), ring_vertex(stack + 1, slice));
+            append_face(ring_vertex(stack, slice + 1), ring_vertex(stack + 1, slice + 1),
+                        ring_vertex(stack + 1, slice));
+        }
+    }
+
+    return text;
+}
+
+std::string scenes::GenerateDenseSphereObj() {
+    return GenerateSphereObj(3.f, 200, 200);
+}
+
+std::vector<scenes::Scene> scenes::CreateScenes(bool spinning) {
+    const std::shared_ptr<Mesh> sphere = ObjParser::Parse(GenerateDenseSphereObj());
+    const std::shared_ptr<Mesh> small_sphere = ObjParser::Parse(GenerateSphereObj(1.f, 12, 24));
+    const std::shared_ptr<Mesh> coarse_sphere = ObjParser::Parse(GenerateSphereObj(20.f, 64, 128));
+
+    assert(sphere && small_sphere && coarse_sphere);
+
+    const Vector2 rotation_velocity = spinning ? Vector2(Radians(90), Radians(45)) : Vector2::Zero();
+
+    return {
+            {"sphere_80k", CullMode::kBack, [=](World *world) {
+                World::ObjectDescription description;
+                description.mesh = sphere;
+                description.position = Vector3(0, 0, 10);
+                description.rotation_velocity = rotation_velocity;
+
+                world->AddObject(description);
+            }},
+
+            {"objects_2000", CullMode::kBack, [=](World *world) {
+                std::mt19937 random(42);
+                std::uniform_real_distribution<float> side(-60.f, 60.f);
+                std::uniform_real_distribution<float> depth(5.f, 120.f);
+                std::uniform_real_distribution<float> angle(0, Radians(360));
+
+                for (size_t i = 0; i < 2000; i++) {
+                    World::ObjectDescription description;
+                    description.mesh = small_sphere;
+                    description.position = Vector3(side(random), side(random), depth(random));
+                    description.rotation_angles = Vector2(angle(random), angle(random));
+                    description.rotation_velocity = rotation_velocity;
+
+                    world->AddObject(description);
+                }
+            }},
+
+            {"inside_sphere", CullMode::kNone, [=](World *world) {
+                World::ObjectDescription description;
+                description.mesh = coarse_sphere;
+                description.position = Vector3(0, 0, 5);
+                description.rotation_velocity = rotation_velocity / 3;
+
+                world->AddObject(description);
+            }},
+    };
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "engine/settings.h"
+#include "engine/world.h"
+
+/**
+ * Generated scenes shared by the benchmarks and the performance gate, so they measure the same work.
+ * The scenes are seen from the default camera, at the origin and looking along the z axis.
+ */
+namespace scenes {
+
+    // .obj text of a UV sphere with outward facing triangles: a fan at each pole and two triangles per quad in between.
+    std::string GenerateSphereObj(float radius, uint32_t stacks, uint32_t slices);
+
+    // .obj text of the 80k faces sphere of the "sphere_80k" scene.
+    std::string GenerateDenseSphereObj();
+
+    struct Scene {
+        const char *name;
+        CullMode cull_mode;
+
+        // Adds the objects of the scene to the world.
+        std::function<void(World *)> populate;
+    };
+
+    /**
+     * The scenes: a single dense mesh, many small meshes scattered around the frustum, and the camera inside of
+     * a large mesh drawn from both sides so the faces crossing the frustum are clipped.
+     *
+     * @param spinning Whether the objects have rotation velocities, otherwise every frame is the same.
+     */
+    std::vector<Scene> CreateScenes(bool spinning);
+
+}
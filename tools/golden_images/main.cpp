@@ -0,0 +1,375 @@
+// Renders fixed scenes offscreen and compares them with reference images, to catch changes of the output of the
+// pipeline. For every scene that differs, the rendered image and an image of the differences are written.
+//
+// Usage: golden_images [scene...] [options]
+//   --references <dir>   Directory of the reference images
+//                        (default: tools/golden_images/references of the source tree).
+//   --output <dir>       Directory the images of the failed scenes are written into (default: current directory).
+//   --tolerance <value>  Largest difference of a color channel of a pixel that still matches (default 2).
+//   --threads <count>    Number of threads the frames are processed with (default: hardware threads).
+//   --update             Write the rendered images as the new references instead of comparing.
+//
+// Without scenes all of them are rendered. Exits with 1 if any scene doesn't match its reference.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "engine/engine.h"
+#include "engine/obj_parser.h"
+#include "engine/math/angle.h"
+#include "engine/math/matrix_transform.h"
+#include "engine/render/image_io.h"
+#include "engine/render/software_renderer.h"
+
+#ifndef GOLDEN_IMAGES_DEFAULT_REFERENCES
+#define GOLDEN_IMAGES_DEFAULT_REFERENCES "references"
+#endif
+
+struct Options {
+    std::vector<std::string> scenes;
+    std::string references_directory = GOLDEN_IMAGES_DEFAULT_REFERENCES;
+    std::string output_directory = ".";
+    uint32_t tolerance = 2;
+    uint32_t threads = 0;
+    bool update = false;
+};
+
+struct Scene {
+    const char *name;
+
+    // Adds the objects, and sets the camera pose and the settings.
+    std::function<void(Engine *)> setup;
+};
+
+struct Image {
+    uint32_t width = 0;
+    uint32_t height = 0;
+    std::vector<Color> pixels;
+};
+
+// Small enough for the references to be kept in the repository.
+constexpr uint32_t kImageWidth = 320;
+constexpr uint32_t kImageHeight = 180;
+
+// The model of the application.
+constexpr char kDodecahedronObj[] =
+        "v -0.57735 -0.57735 0.57735\n"
+        "v 0.934172 0.356822 0\n"
+        "v 0.934172 -0.356822 0\n"
+        "v -0.934172 0.356822 0\n"
+        "v -0.934172 -0.356822 0\n"
+        "v 0 0.934172 0.356822\n"
+        "v 0 0.934172 -0.356822\n"
+        "v 0.356822 0 -0.934172\n"
+        "v -0.356822 0 -0.934172\n"
+        "v 0 -0.934172 -0.356822\n"
+        "v 0 -0.934172 0.356822\n"
+        "v 0.356822 0 0.934172\n"
+        "v -0.356822 0 0.934172\n"
+        "v 0.57735 0.57735 -0.57735\n"
+        "v 0.57735 0.57735 0.57735\n"
+        "v -0.57735 0.57735 -0.57735\n"
+        "v -0.57735 0.57735 0.57735\n"
+        "v 0.57735 -0.57735 -0.57735\n"
+        "v 0.57735 -0.57735 0.57735\n"
+        "v -0.57735 -0.57735 -0.57735\n"
+        "f 19 3 2\nf 12 19 2\nf 15 12 2\nf 8 14 2\nf 18 8 2\nf 3 18 2\n"
+        "f 20 5 4\nf 9 20 4\nf 16 9 4\nf 13 17 4\nf 1 13 4\nf 5 1 4\n"
+        "f 7 16 4\nf 6 7 4\nf 17 6 4\nf 6 15 2\nf 7 6 2\nf 14 7 2\n"
+        "f 10 18 3\nf 11 10 3\nf 19 11 3\nf 11 1 5\nf 10 11 5\nf 20 10 5\n"
+        "f 20 9 8\nf 10 20 8\nf 18 10 8\nf 9 16 7\nf 8 9 7\nf 14 8 7\n"
+        "f 12 15 6\nf 13 12 6\nf 17 13 6\nf 13 1 11\nf 12 13 11\nf 19 12 11\n";
+
+// Faces turned away from the camera, one turned towards it, and a degenerate one, all in the same face cluster.
+// The cluster must not be culled as a whole.
+constexpr char kDegenerateFacesObj[] =
+        "v -1 -1 0.5\nv 1 -1 0.5\nv 1 1 0.5\nv -1 1 0.5\n"
+        "v 1 -1 -0.5\nv 1 1 -0.5\nv 1 -1 0.4\n"
+        "f 1 2 3\nf 1 3 4\nf 2 3 4\nf 5 7 6\nf 1 2 2\n";
+
+static void PrintUsage(const char *program) {
+    std::printf("Usage: %s [scene...] [--references <dir>] [--output <dir>] [--tolerance <value>]\n"
+                "       [--threads <count>] [--update]\n", program);
+}
+
+static bool ParseOptions(int argc, char **argv, Options *options) {
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        const bool has_value = i + 1 < argc;
+
+        if (std::strcmp(arg, "--references") == 0 && has_value)
+            options->references_directory = argv[++i];
+        else if (std::strcmp(arg, "--output") == 0 && has_value)
+            options->output_directory = argv[++i];
+        else if (std::strcmp(arg, "--tolerance") == 0 && has_value)
+            options->tolerance = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        else if (std::strcmp(arg, "--threads") == 0 && has_value)
+            options->threads = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        else if (std::strcmp(arg, "--update") == 0)
+            options->update = true;
+        else if (arg[0] != '-')
+            options->scenes.emplace_back(arg);
+        else
+            return false;
+    }
+
+    return true;
+}
+
+static std::vector<Scene> CreateScenes(const std::shared_ptr<Mesh> &dodecahedron) {
+    const auto add_object = [dodecahedron](Engine *engine, const Vector3 &position, const Vector2 &rotation_angles,
+                                           const Color &color) {
+        World::ObjectDescription description;
+        description.mesh = dodecahedron;
+        description.position = position;
+        description.rotation_angles = rotation_angles;
+        description.color = color;
+
+        engine->GetWorld()->AddObject(description);
+    };
+
+    const Color model_color(0xFF, 0xD3, 0xC9, 0xFF);
+
+    // The camera is at the origin and looks along the z axis unless the scene moves it.
+    return {
+            {"dodecahedron", [=](Engine *engine) {
+                add_object(engine, Vector3(0, 0, 10), Vector2(Radians(30), Radians(20)), model_color);
+            }},
+
+            {"cull_front", [=](Engine *engine) {
+                engine->AccessSettings()->cull_mode = CullMode::kFront;
+                add_object(engine, Vector3(0, 0, 10), Vector2(Radians(30), Radians(20)), model_color);
+            }},
+
+            {"debug_lines", [=](Engine *engine) {
+                DebugSettings &debug = engine->AccessSettings()->debug;
+                debug.triangle.outlines.show = true;
+                debug.triangle.normals.show = true;
+                debug.clipped_triangle.outlines.show = true;
+                debug.clipped_triangle.outlines.color = Color::Red();
+
+                add_object(engine, Vector3(0, 0, 10), Vector2(Radians(30), Radians(20)), model_color);
+                add_object(engine, Vector3(9, 2, 8), Vector2(Radians(70), Radians(10)), model_color);
+            }},
+
+            // The model crosses the near plane and the sides of the frustum.
+            {"near_clipping", [=](Engine *engine) {
+                engine->AccessSettings()->cull_mode = CullMode::kNone;
+                add_object(engine, Vector3(0.5f, -0.3f, 2.6f), Vector2(Radians(15), Radians(40)), model_color);
+            }},
+
+            // Objects around a moved and turned camera, many of them outside of the frustum or crossing it.
+            {"objects", [=](Engine *engine) {
+                for (int x = -6; x <= 6; x++) {
+                    for (int z = -6; z <= 6; z++) {
+                        const auto hue = static_cast<uint8_t>((x + 6) * 20);
+                        const auto shade = static_cast<uint8_t>((z + 6) * 20);
+
+                        add_object(engine, Vector3(static_cast<float>(x) * 5, 0, static_cast<float>(z) * 5),
+                                   Vector2(Radians(static_cast<float>(x * 25)), Radians(static_cast<float>(z * 15))),
+                                   Color(hue, shade, 0xC0, 0xFF));
+                    }
+                }
+
+                const std::shared_ptr<Camera> camera = engine->GetActiveCamera();
+                camera->SetWorldPosition(Vector3(-4, 6, -22));
+                camera->SetRotationAngles(Vector2(Radians(20), Radians(-25)));
+            }},
+
+            // The mesh has no normals, the parser computes smooth ones from the faces. The second object is clipped.
+            {"smooth_shading", [=](Engine *engine) {
+                engine->AccessSettings()->shading = Shading::kSmooth;
+
+                World::ObjectDescription description;
+                description.mesh = ObjParser::Parse(kDodecahedronObj);
+                description.mesh->Transform(matrix::Scale(3.f));
+                description.color = model_color;
+
+                description.position = Vector3(0, 0, 10);
+                description.rotation_angles = Vector2(Radians(30), Radians(20));
+                engine->GetWorld()->AddObject(description);
+
+                description.position = Vector3(-7.5f, 1, 8);
+                description.rotation_angles = Vector2(Radians(70), Radians(10));
+                engine->GetWorld()->AddObject(description);
+            }},
+
+            {"degenerate_faces", [=](Engine *engine) {
+                World::ObjectDescription description;
+                description.mesh = ObjParser::Parse(kDegenerateFacesObj);
+                description.mesh->Transform(matrix::Scale(2.f));
+                description.position = Vector3(3, 0, 8);
+                description.color = model_color;
+
+                engine->GetWorld()->AddObject(description);
+            }},
+    };
+}
+
+static Image Render(const Scene &scene, const std::shared_ptr<jobs::JobSystem> &job_system) {
+    auto software_renderer = std::make_shared<render::SoftwareRenderer>();
+    software_renderer->Resize(kImageWidth, kImageHeight);
+    software_renderer->SetJobSystem(job_system);
+
+    std::shared_ptr<render::Renderer> renderer = software_renderer;
+
+    Engine engine;
+    engine.SetJobSystem(job_system);
+    engine.Initialize(ViewPort(kImageWidth, kImageHeight), renderer);
+
+    scene.setup(&engine);
+
+    software_renderer->Clear(Color(0xD7, 0xD7, 0xD7, 0xFF));
+    engine.Draw();
+
+    Image image;
+    image.width = kImageWidth;
+    image.height = kImageHeight;
+    image.pixels.assign(software_renderer->GetColorBuffer(),
+                        software_renderer->GetColorBuffer() + static_cast<size_t>(kImageWidth) * kImageHeight);
+
+    return image;
+}
+
+static uint32_t ChannelDifference(const Color &lhs, const Color &rhs) {
+    const auto difference = [](uint8_t a, uint8_t b) {
+        return static_cast<uint32_t>(std::abs(static_cast<int32_t>(a) - static_cast<int32_t>(b)));
+    };
+
+    return std::max({difference(lhs.r, rhs.r), difference(lhs.g, rhs.g), difference(lhs.b, rhs.b)});
+}
+
+/**
+ * Compares the image with the reference of the scene, and writes the rendered image and the differences if they
+ * don't match: the pixels that differ are red, the others are a faded copy of the reference.
+ *
+ * @return Whether the images match.
+ */
+static bool Compare(const Scene &scene, const Image &image, const Options &options) {
+    const std::string reference_path = options.references_directory + "/" + scene.name + ".ppm";
+
+    Image reference;
+    if (!render::ReadPPM(reference_path, &reference.width, &reference.height, &reference.pixels)) {
+        std::printf("%-16s FAILED: unable to read the reference %s\n", scene.name, reference_path.c_str());
+        return false;
+    }
+
+    if (reference.width != image.width || reference.height != image.height) {
+        std::printf("%-16s FAILED: the reference is %ux%u, the image is %ux%u\n", scene.name, reference.width,
+                    reference.height, image.width, image.height);
+        return false;
+    }
+
+    std::vector<Color> differences(image.pixels.size());
+    size_t differing_pixels_count = 0;
+    uint32_t max_difference = 0;
+
+    for (size_t i = 0; i < image.pixels.size(); i++) {
+        const Color &expected = reference.pixels[i];
+        const uint32_t difference = ChannelDifference(image.pixels[i], expected);
+
+        max_difference = std::max(max_difference, difference);
+
+        if (difference > options.tolerance) {
+            differences[i] = Color::Red();
+            differing_pixels_count++;
+        } else {
+            const auto faded = static_cast<uint8_t>(192 + (expected.r + expected.g + expected.b) / 12);
+            differences[i] = Color::RGBA(faded, faded, faded);
+        }
+    }
+
+    if (differing_pixels_count == 0) {
+        std::printf("%-16s ok (max channel difference %u)\n", scene.name, max_difference);
+        return true;
+    }
+
+    std::printf("%-16s FAILED: %zu pixels differ by more than %u (max %u)\n", scene.name, differing_pixels_count,
+                options.tolerance, max_difference);
+
+    const std::string image_path = options.output_directory + "/" + scene.name + ".actual.ppm";
+    const std::string differences_path = options.output_directory + "/" + scene.name + ".diff.ppm";
+
+    if (render::WritePPM(image_path, image.width, image.height, image.pixels.data()) &&
+        render::WritePPM(differences_path, image.width, image.height, differences.data()))
+        std::printf("%-16s wrote %s and %s\n", "", image_path.c_str(), differences_path.c_str());
+    else
+        std::printf("%-16s unable to write the images into %s\n", "", options.output_directory.c_str());
+
+    return false;
+}
+
+int main(int argc, char **argv) {
+    Options options;
+    if (!ParseOptions(argc, argv, &options)) {
+        PrintUsage(argv[0]);
+        return 1;
+    }
+
+    const std::shared_ptr<Mesh> dodecahedron = ObjParser::Parse(kDodecahedronObj);
+    if (!dodecahedron) {
+        std::printf("Unable to parse the model.\n");
+        return 1;
+    }
+
+    // Like the application and the headless runner.
+    dodecahedron->Transform(matrix::Scale(3.f));
+
+    const std::vector<Scene> scenes = CreateScenes(dodecahedron);
+
+    for (const std::string &name : options.scenes) {
+        const bool found = std::any_of(scenes.begin(), scenes.end(), [&](const Scene &scene) {
+            return name == scene.name;
+        });
+
+        if (!found) {
+            std::printf("Unknown scene %s. Scenes:", name.c_str());
+            for (const Scene &scene : scenes)
+                std::printf(" %s", scene.name);
+            std::printf("\n");
+            return 1;
+        }
+    }
+
+    auto job_system = std::make_shared<jobs::JobSystem>(options.threads);
+
+    size_t failed_scenes_count = 0;
+
+    for (const Scene &scene : scenes) {
+        const bool selected = options.scenes.empty() ||
+                              std::find(options.scenes.begin(), options.scenes.end(), scene.name) !=
+                              options.scenes.end();
+        if (!selected)
+            continue;
+
+        const Image image = Render(scene, job_system);
+
+        if (options.update) {
+            const std::string path = options.references_directory + "/" + scene.name + ".ppm";
+
+            if (!render::WritePPM(path, image.width, image.height, image.pixels.data())) {
+                std::printf("Unable to write %s.\n", path.c_str());
+                return 1;
+            }
+
+            std::printf("%-16s updated %s\n", scene.name, path.c_str());
+            continue;
+        }
+
+        if (!Compare(scene, image, options))
+            failed_scenes_count++;
+    }
+
+    if (failed_scenes_count > 0) {
+        std::printf("\n%zu scenes don't match their references.\n", failed_scenes_count);
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,318 @@
+// Renders a spinning .obj model offscreen with a fixed time step and reports per-frame timings.
+//
+// Usage: spinning_dodecahedron_headless <model.obj> [options]
+//   --frames <count>      Number of frames to render (default 600).
+//   --timestep <seconds>  Fixed time step of every update (default 1/60).
+//   --width <pixels>      Framebuffer width (default 1280).
+//   --height <pixels>     Framebuffer height (default 720).
+//   --timings <file.csv>  Write the per-frame timings to a CSV file.
+//   --dump-frames <dir>   Write every rendered frame as a PPM image into the directory.
+//   --vertex-layout <aos|soa>  Vertex layout of the mesh (default aos).
+//   --threads <count>     Number of threads the frame is processed with (default: hardware threads).
+//   --no-mesh-cache       Parse the model without reading or writing its mesh cache.
+//   --verify-mesh-cache   Check the whole mesh cache against its checksum before using it.
+//   --cull <back|front|none>  Faces that are not drawn (default back).
+//   --shading <flat|smooth>  Shade the faces flat or with the vertex normals of the model (default flat).
+//   --profile <trace.json>  Profile the stages of every frame, print their breakdown and write a Chrome trace.
+//   --statistics          Print the pipeline statistics, averaged over the frames.
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "engine/engine.h"
+#include "engine/obj_parser.h"
+#include "engine/math/matrix_transform.h"
+#include "engine/profiler/profiler.h"
+#include "engine/render/image_io.h"
+#include "engine/render/software_renderer.h"
+
+struct Options {
+    std::string model_path;
+    uint32_t frames = 600;
+    float timestep = 1.f / 60.f;
+    uint32_t width = 1280;
+    uint32_t height = 720;
+    std::string timings_path;
+    std::string dump_frames_directory;
+    Mesh::VertexLayout vertex_layout = Mesh::VertexLayout::kArrayOfStructures;
+    uint32_t threads = 0;
+    bool use_mesh_cache = true;
+    bool verify_mesh_cache = false;
+    CullMode cull_mode = CullMode::kBack;
+    Shading shading = Shading::kFlat;
+    std::string profile_path;
+    bool print_statistics = false;
+};
+
+struct FrameTimings {
+    double update_ms;
+    double draw_ms;
+};
+
+static void PrintUsage(const char *program) {
+    std::printf("Usage: %s <model.obj> [--frames <count>] [--timestep <seconds>] [--width <pixels>]\n"
+                "       [--height <pixels>] [--timings <file.csv>] [--dump-frames <directory>]\n"
+                "       [--vertex-layout <aos|soa>] [--threads <count>] [--no-mesh-cache] [--verify-mesh-cache]\n"
+                "       [--cull <back|front|none>] [--shading <flat|smooth>] [--profile <trace.json>]\n"
+                "       [--statistics]\n", program);
+}
+
+static bool ParseOptions(int argc, char **argv, Options *options) {
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        const bool has_value = i + 1 < argc;
+
+        if (std::strcmp(arg, "--frames") == 0 && has_value)
+            options->frames = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        else if (std::strcmp(arg, "--timestep") == 0 && has_value)
+            options->timestep = std::strtof(argv[++i], nullptr);
+        else if (std::strcmp(arg, "--width") == 0 && has_value)
+            options->width = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        else if (std::strcmp(arg, "--height") == 0 && has_value)
+            options->height = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        else if (std::strcmp(arg, "--timings") == 0 && has_value)
+            options->timings_path = argv[++i];
+        else if (std::strcmp(arg, "--dump-frames") == 0 && has_value)
+            options->dump_frames_directory = argv[++i];
+        else if (std::strcmp(arg, "--vertex-layout") == 0 && has_value) {
+            const char *layout = argv[++i];
+            if (std::strcmp(layout, "aos") == 0)
+                options->vertex_layout = Mesh::VertexLayout::kArrayOfStructures;
+            else if (std::strcmp(layout, "soa") == 0)
+                options->vertex_layout = Mesh::VertexLayout::kStructureOfArrays;
+            else
+                return false;
+        } else if (std::strcmp(arg, "--threads") == 0 && has_value)
+            options->threads = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        else if (std::strcmp(arg, "--no-mesh-cache") == 0)
+            options->use_mesh_cache = false;
+        else if (std::strcmp(arg, "--verify-mesh-cache") == 0)
+            options->verify_mesh_cache = true;
+        else if (std::strcmp(arg, "--cull") == 0 && has_value) {
+            const char *mode = argv[++i];
+            if (std::strcmp(mode, "back") == 0)
+                options->cull_mode = CullMode::kBack;
+            else if (std::strcmp(mode, "front") == 0)
+                options->cull_mode = CullMode::kFront;
+            else if (std::strcmp(mode, "none") == 0)
+                options->cull_mode = CullMode::kNone;
+            else
+                return false;
+        } else if (std::strcmp(arg, "--shading") == 0 && has_value) {
+            const char *shading = argv[++i];
+            if (std::strcmp(shading, "flat") == 0)
+                options->shading = Shading::kFlat;
+            else if (std::strcmp(shading, "smooth") == 0)
+                options->shading = Shading::kSmooth;
+            else
+                return false;
+        } else if (std::strcmp(arg, "--profile") == 0 && has_value)
+            options->profile_path = argv[++i];
+        else if (std::strcmp(arg, "--statistics") == 0)
+            options->print_statistics = true;
+        else if (arg[0] != '-' && options->model_path.empty())
+            options->model_path = arg;
+        else
+            return false;
+    }
+
+    return !options->model_path.empty() && options->width > 0 && options->height > 0;
+}
+
+static double MillisecondsBetween(std::chrono::steady_clock::time_point from,
+                                  std::chrono::steady_clock::time_point to) {
+    return std::chrono::duration<double, std::milli>(to - from).count();
+}
+
+static bool InitializeScene(Engine *engine, const Options &options) {
+    const std::string &model_path = options.model_path;
+
+    const auto load_start = std::chrono::steady_clock::now();
+
+    std::shared_ptr<Mesh> mesh = ObjParser::ParseFile(model_path, engine->GetJobSystem().get(),
+                                                      options.use_mesh_cache, options.verify_mesh_cache);
+    if (!mesh) {
+        std::printf("Unable to load %s.\n", model_path.c_str());
+        return false;
+    }
+
+    std::printf("Model load: %.2f ms%s\n", MillisecondsBetween(load_start, std::chrono::steady_clock::now()),
+                mesh->HasExternalArrays() ? " (mesh cache)" : "");
+
+    mesh->Transform(matrix::Scale(3.f));
+    mesh->SetVertexLayout(options.vertex_layout);
+
+    World::ObjectDescription description;
+    description.mesh = mesh;
+    description.color = Color(0xFF, 0xD3, 0xC9, 0xFF);
+    description.position = Vector3(10, 10, 10);
+    description.rotation_velocity = Vector2(M_PI / 2, M_PI / 2);
+
+    const World::ObjectHandle object = engine->GetWorld()->AddObject(description);
+    engine->GetActiveCamera()->AttachTo(engine->GetWorld(), object);
+
+    return true;
+}
+
+static bool WriteTimings(const std::string &path, const std::vector<FrameTimings> &timings) {
+    FILE *file = std::fopen(path.c_str(), "w");
+    if (!file)
+        return false;
+
+    std::fprintf(file, "frame,update_ms,draw_ms,total_ms\n");
+
+    for (size_t frame = 0; frame < timings.size(); frame++) {
+        const FrameTimings &t = timings[frame];
+        std::fprintf(file, "%zu,%.6f,%.6f,%.6f\n", frame, t.update_ms, t.draw_ms, t.update_ms + t.draw_ms);
+    }
+
+    std::fclose(file);
+    return true;
+}
+
+static void PrintSummary(const std::vector<FrameTimings> &timings) {
+    if (timings.empty())
+        return;
+
+    double total = 0;
+    double min = timings[0].update_ms + timings[0].draw_ms;
+    double max = min;
+
+    for (const FrameTimings &t : timings) {
+        const double frame_ms = t.update_ms + t.draw_ms;
+        total += frame_ms;
+        min = std::min(min, frame_ms);
+        max = std::max(max, frame_ms);
+    }
+
+    const double average = total / static_cast<double>(timings.size());
+
+    std::printf("Frames: %zu\n", timings.size());
+    std::printf("Frame time: avg %.4f ms, min %.4f ms, max %.4f ms\n", average, min, max);
+    std::printf("Throughput: %.2f frames/s\n", 1000.0 / average);
+}
+
+static void PrintStages() {
+    std::printf("Stages (last %zu frames):\n", profiler::kHistoryFramesCount);
+
+    for (const profiler::StageStatistics &stage : profiler::GetStageStatistics()) {
+        std::printf("  %*s%-*s avg %.4f ms, max %.4f ms\n", static_cast<int>(stage.depth * 2), "",
+                    static_cast<int>(24 - stage.depth * 2), stage.name, stage.average_ms, stage.max_ms);
+    }
+}
+
+static void PrintStatistics(const PipelineStatistics &total, uint32_t frames) {
+    const auto average = [&](uint64_t value) {
+        return static_cast<double>(value) / static_cast<double>(std::max(frames, 1u));
+    };
+
+    std::printf("Pipeline statistics (per frame):\n");
+    std::printf("  Objects: visited %.1f, culled %.1f, skipped %.1f\n", average(total.objects_visited),
+                average(total.objects_culled), average(total.objects_skipped));
+    std::printf("  Faces: in %.1f, culled %.1f, outside %.1f, clipped %.1f, clipped away %.1f\n",
+                average(total.faces_in), average(total.faces_culled), average(total.faces_outside),
+                average(total.faces_clipped), average(total.faces_clipped_away));
+    std::printf("  Triangles generated by clipping: %.1f\n", average(total.triangles_generated));
+    std::printf("  Submitted: triangles %.1f, lines %.1f, draw calls %.1f\n", average(total.triangles_submitted),
+                average(total.lines_submitted), average(total.draw_calls));
+}
+
+int main(int argc, char **argv) {
+    Options options;
+    if (!ParseOptions(argc, argv, &options)) {
+        PrintUsage(argv[0]);
+        return 1;
+    }
+
+    auto job_system = std::make_shared<jobs::JobSystem>(options.threads);
+
+    auto software_renderer = std::make_shared<render::SoftwareRenderer>();
+    software_renderer->Resize(options.width, options.height);
+    software_renderer->SetJobSystem(job_system);
+
+    std::shared_ptr<render::Renderer> renderer = software_renderer;
+
+    Engine engine;
+    engine.SetJobSystem(job_system);
+    engine.Initialize(ViewPort(static_cast<float>(options.width), static_cast<float>(options.height)), renderer);
+    engine.AccessSettings()->cull_mode = options.cull_mode;
+    engine.AccessSettings()->shading = options.shading;
+
+    if (!InitializeScene(&engine, options))
+        return 1;
+
+    const Color background_color(0xD7, 0xD7, 0xD7, 0xFF);
+
+    std::vector<FrameTimings> timings;
+    timings.reserve(options.frames);
+
+    PipelineStatistics total_statistics;
+
+    const bool profile = !options.profile_path.empty();
+
+    if (profile) {
+        profiler::SetEnabled(true);
+        profiler::StartCapture(options.frames);
+    }
+
+    for (uint32_t frame = 0; frame < options.frames; frame++) {
+        profiler::BeginFrame();
+
+        const auto frame_start = std::chrono::steady_clock::now();
+
+        engine.Update(options.timestep);
+
+        const auto update_end = std::chrono::steady_clock::now();
+
+        software_renderer->Clear(background_color);
+        engine.Draw();
+
+        const auto draw_end = std::chrono::steady_clock::now();
+
+        total_statistics += engine.GetPipelineStatistics();
+
+        timings.push_back(FrameTimings{MillisecondsBetween(frame_start, update_end),
+                                       MillisecondsBetween(update_end, draw_end)});
+
+        profiler::EndFrame();
+
+        if (!options.dump_frames_directory.empty()) {
+            char filename[32];
+            std::snprintf(filename, sizeof(filename), "/frame_%05u.ppm", frame);
+
+            const std::string path = options.dump_frames_directory + filename;
+            if (!render::WritePPM(path, software_renderer->GetWidth(), software_renderer->GetHeight(),
+                                  software_renderer->GetColorBuffer())) {
+                std::printf("Unable to write %s.\n", path.c_str());
+                return 1;
+            }
+        }
+    }
+
+    if (!options.timings_path.empty() && !WriteTimings(options.timings_path, timings)) {
+        std::printf("Unable to write %s.\n", options.timings_path.c_str());
+        return 1;
+    }
+
+    if (profile) {
+        if (!profiler::WriteChromeTrace(options.profile_path)) {
+            std::printf("Unable to write %s.\n", options.profile_path.c_str());
+            return 1;
+        }
+
+        PrintStages();
+    }
+
+    if (options.print_statistics)
+        PrintStatistics(total_statistics, options.frames);
+
+    std::printf("Threads: %u\n", job_system->GetThreadsCount());
+    PrintSummary(timings);
+
+    return 0;
+}
@@ -0,0 +1,525 @@
+// Runs a fixed set of headless parse and render scenarios and compares the median timings against a baseline.
+// Exits with 1 if a metric got slower than its baseline by more than its tolerance.
+//
+// Usage: perf_gate [options]
+//   --baseline <file.json>  Baseline to compare against (default: tools/perf_gate/baseline.json of the source tree).
+//   --update                Write the measured medians to the baseline instead of comparing. The tolerances of the
+//                           metrics already in the baseline are kept.
+//   --output <file.json>    Also write the measured metrics, in the format of the baseline.
+//   --threads <count>       Number of threads the frames are processed with (default 1).
+//
+// The metrics are compared relative to a fixed reference loop timed around every run, so that a machine that is busier
+// or throttled makes both slower rather than failing the gate. The baseline should still be recorded on the kind of
+// machine the gate runs on, since the scenarios and the reference loop don't scale the same with the hardware.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "engine/engine.h"
+#include "engine/obj_parser.h"
+#include "engine/render/software_renderer.h"
+
+#include "scenes.h"
+
+#ifndef PERF_GATE_DEFAULT_BASELINE
+#define PERF_GATE_DEFAULT_BASELINE "baseline.json"
+#endif
+
+struct Options {
+    std::string baseline_path = PERF_GATE_DEFAULT_BASELINE;
+    bool update = false;
+    std::string output_path;
+    uint32_t threads = 1;
+};
+
+struct Metric {
+    std::string name;
+
+    // Median time, and its ratio to the time of the reference loop measured in the same run.
+    double median_ms;
+    double relative;
+
+    // Allowed slowdown relative to the baseline median, e.g. 0.2 for 20%.
+    double tolerance;
+};
+
+static void PrintUsage(const char *program) {
+    std::printf("Usage: %s [--baseline <file.json>] [--update] [--output <file.json>] [--threads <count>]\n",
+                program);
+}
+
+static bool ParseOptions(int argc, char **argv, Options *options) {
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        const bool has_value = i + 1 < argc;
+
+        if (std::strcmp(arg, "--baseline") == 0 && has_value)
+            options->baseline_path = argv[++i];
+        else if (std::strcmp(arg, "--update") == 0)
+            options->update = true;
+        else if (std::strcmp(arg, "--output") == 0 && has_value)
+            options->output_path = argv[++i];
+        else if (std::strcmp(arg, "--threads") == 0 && has_value)
+            options->threads = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        else
+            return false;
+    }
+
+    return true;
+}
+
+// Reader of the baseline files: a JSON object with a "metrics" array of {"name", "relative", "tolerance"} objects.
+// Other members are skipped.
+class BaselineReader {
+public:
+    explicit BaselineReader(const std::string &text) : text_(text) {}
+
+    bool Read(std::vector<Metric> *metrics) {
+        if (!Accept('{'))
+            return false;
+
+        if (Accept('}'))
+            return AtEnd();
+
+        do {
+            std::string key;
+            if (!ReadString(&key) || !Accept(':'))
+                return false;
+
+            const bool success = key == "metrics" ? ReadMetrics(metrics) : SkipValue();
+            if (!success)
+                return false;
+        } while (Accept(','));
+
+        return Accept('}') && AtEnd();
+    }
+
+private:
+    bool ReadMetrics(std::vector<Metric> *metrics) {
+        if (!Accept('['))
+            return false;
+
+        if (Accept(']'))
+            return true;
+
+        do {
+            Metric metric{"", 0, 0, 0};
+
+            if (!Accept('{'))
+                return false;
+
+            do {
+                std::string key;
+                if (!ReadString(&key) || !Accept(':'))
+                    return false;
+
+                bool success;
+                if (key == "name")
+                    success = ReadString(&metric.name);
+                else if (key == "median_ms")
+                    success = ReadNumber(&metric.median_ms);
+                else if (key == "relative")
+                    success = ReadNumber(&metric.relative);
+                else if (key == "tolerance")
+                    success = ReadNumber(&metric.tolerance);
+                else
+                    success = SkipValue();
+
+                if (!success)
+                    return false;
+            } while (Accept(','));
+
+            if (!Accept('}') || metric.name.empty() || metric.relative <= 0)
+                return false;
+
+            metrics->push_back(metric);
+        } while (Accept(','));
+
+        return Accept(']');
+    }
+
+    bool ReadString(std::string *string) {
+        if (!Accept('"'))
+            return false;
+
+        string->clear();
+
+        while (position_ < text_.size() && text_[position_] != '"') {
+            if (text_[position_] == '\\')
+                position_++;
+
+            if (position_ < text_.size())
+                string->push_back(text_[position_++]);
+        }
+
+        return Accept('"');
+    }
+
+    bool ReadNumber(double *number) {
+        SkipWhitespace();
+
+        const char *begin = text_.c_str() + position_;
+        char *end = nullptr;
+        *number = std::strtod(begin, &end);
+
+        if (end == begin)
+            return false;
+
+        position_ += static_cast<size_t>(end - begin);
+        return true;
+    }
+
+    bool SkipValue() {
+        SkipWhitespace();
+        if (position_ == text_.size())
+            return false;
+
+        const char c = text_[position_];
+
+        if (c == '"') {
+            std::string string;
+            return ReadString(&string);
+        }
+
+        if (c == '{' || c == '[') {
+            const char close = c == '{' ? '}' : ']';
+            position_++;
+
+            if (Accept(close))
+                return true;
+
+            do {
+                if (c == '{') {
+                    std::string key;
+                    if (!ReadString(&key) || !Accept(':'))
+                        return false;
+                }
+
+                if (!SkipValue())
+                    return false;
+            } while (Accept(','));
+
+            return Accept(close);
+        }
+
+        // A number or a literal.
+        const size_t begin = position_;
+        while (position_ < text_.size() && std::strchr(",}] \t\r\n", text_[position_]) == nullptr)
+            position_++;
+
+        return position_ > begin;
+    }
+
+    void SkipWhitespace() {
+        while (position_ < text_.size() && std::strchr(" \t\r\n", text_[position_]) != nullptr)
+            position_++;
+    }
+
+    bool Accept(char c) {
+        SkipWhitespace();
+
+        if (position_ < text_.size() && text_[position_] == c) {
+            position_++;
+            return true;
+        }
+
+        return false;
+    }
+
+    bool AtEnd() {
+        SkipWhitespace();
+        return position_ == text_.size();
+    }
+
+private:
+    const std::string &text_;
+    size_t position_ = 0;
+};
+
+static bool ReadBaseline(const std::string &path, std::vector<Metric> *metrics) {
+    FILE *file = std::fopen(path.c_str(), "rb");
+    if (!file)
+        return false;
+
+    std::string text;
+    char buffer[4096];
+    size_t read;
+
+    while ((read = std::fread(buffer, 1, sizeof(buffer), file)) > 0)
+        text.append(buffer, read);
+
+    std::fclose(file);
+
+    return BaselineReader(text).Read(metrics);
+}
+
+static bool WriteBaseline(const std::string &path, const std::vector<Metric> &metrics) {
+    FILE *file = std::fopen(path.c_str(), "w");
+    if (!file)
+        return false;
+
+    std::fprintf(file, "{\n  \"metrics\": [");
+
+    for (size_t i = 0; i < metrics.size(); i++) {
+        const Metric &metric = metrics[i];
+        std::fprintf(file, "%s\n    {\"name\": \"%s\", \"relative\": %.4f, \"median_ms\": %.4f, \"tolerance\": %.2f}",
+                     i == 0 ? "" : ",", metric.name.c_str(), metric.relative, metric.median_ms, metric.tolerance);
+    }
+
+    std::fprintf(file, "\n  ]\n}\n");
+
+    const bool success = std::ferror(file) == 0;
+    std::fclose(file);
+
+    return success;
+}
+
+static double MillisecondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+static double Median(std::vector<double> values) {
+    std::sort(values.begin(), values.end());
+
+    const size_t middle = values.size() / 2;
+    return values.size() % 2 == 1 ? values[middle] : (values[middle - 1] + values[middle]) / 2;
+}
+
+// Median time of parsing the text on the calling thread.
+static double MeasureParse(const std::string &text) {
+    constexpr uint32_t kRepetitions = 15;
+
+    std::vector<double> times;
+
+    for (uint32_t repetition = 0; repetition < kRepetitions; repetition++) {
+        const auto start = std::chrono::steady_clock::now();
+        const std::shared_ptr<Mesh> mesh = ObjParser::Parse(text);
+        times.push_back(MillisecondsSince(start));
+    }
+
+    return Median(times);
+}
+
+/**
+ * Median time of a frame of the scene rendered offscreen: update, clear, draw and rasterization.
+ * The objects spin with a fixed time step, so every run renders the same frames.
+ */
+static double MeasureRender(const Options &options, const scenes::Scene &scene) {
+    constexpr uint32_t kWarmUpFramesCount = 5;
+    constexpr uint32_t kFramesCount = 60;
+
+    auto job_system = std::make_shared<jobs::JobSystem>(options.threads);
+
+    auto software_renderer = std::make_shared<render::SoftwareRenderer>();
+    software_renderer->Resize(1280, 720);
+    software_renderer->SetJobSystem(job_system);
+
+    std::shared_ptr<render::Renderer> renderer = software_renderer;
+
+    Engine engine;
+    engine.SetJobSystem(job_system);
+    engine.Initialize(ViewPort(1280, 720), renderer);
+    engine.AccessSettings()->cull_mode = scene.cull_mode;
+
+    scene.populate(engine.GetWorld().get());
+
+    std::vector<double> times;
+
+    for (uint32_t frame = 0; frame < kWarmUpFramesCount + kFramesCount; frame++) {
+        const auto start = std::chrono::steady_clock::now();
+
+        engine.Update(1.f / 60.f);
+        software_renderer->Clear(Color(0xD7, 0xD7, 0xD7, 0xFF));
+        engine.Draw();
+
+        if (frame >= kWarmUpFramesCount)
+            times.push_back(MillisecondsSince(start));
+    }
+
+    return Median(times);
+}
+
+/**
+ * Median time of a fixed loop of scalar math over a few megabytes of memory, like the work of the scenarios.
+ * The scenarios are compared relative to it, so a machine that is slower for a while, e.g. because of the other
+ * processes or of the frequency scaling, doesn't look like a regression.
+ */
+static double MeasureReference() {
+    constexpr uint32_t kRepetitions = 9;
+    constexpr size_t kPointsCount = 1 << 20;
+
+    Matrix4 matrix;
+    for (size_t row = 0; row < 4; row++)
+        for (size_t col = 0; col < 4; col++)
+            matrix[row][col] = static_cast<float>(row * 4 + col + 1) / 16.f;
+
+    std::vector<Vector4> points(kPointsCount);
+    for (size_t i = 0; i < kPointsCount; i++)
+        points[i] = Vector4(static_cast<float>(i % 97), static_cast<float>(i % 89), static_cast<float>(i % 83), 1);
+
+    std::vector<double> times;
+
+    for (uint32_t repetition = 0; repetition < kRepetitions; repetition++) {
+        const auto start = std::chrono::steady_clock::now();
+
+        for (Vector4 &point : points) {
+            point = matrix * point;
+            point[3] = 1;
+        }
+
+        times.push_back(MillisecondsSince(start));
+    }
+
+    volatile float sink = points[kPointsCount / 2][0];
+    (void) sink;
+
+    return Median(times);
+}
+
+// Number of times every scenario is run. The baseline is measured over more runs, since every later run is compared
+// with it.
+static constexpr uint32_t kRunsCount = 5;
+static constexpr uint32_t kBaselineRunsCount = 15;
+
+static std::vector<Metric> RunScenarios(const Options &options) {
+    std::vector<Metric> metrics;
+
+    // Every run is divided by the reference loop measured around it, so the ratio doesn't depend on the speed of
+    // the machine at the time of the run. The median of the runs ignores the runs disturbed by other processes.
+    const uint32_t runs_count = options.update ? kBaselineRunsCount : kRunsCount;
+
+    const auto add_metric = [&](const char *name, double tolerance, const std::function<double()> &measure) {
+        std::vector<double> medians_ms;
+        std::vector<double> ratios;
+
+        for (uint32_t run = 0; run < runs_count; run++) {
+            const double reference_before_ms = MeasureReference();
+            const double median_ms = measure();
+            const double reference_after_ms = MeasureReference();
+
+            medians_ms.push_back(median_ms);
+            ratios.push_back(median_ms * 2 / (reference_before_ms + reference_after_ms));
+        }
+
+        const Metric metric{name, Median(medians_ms), Median(ratios), tolerance};
+
+        std::printf("%-32s %10.3f ms %10.4f relative\n", name, metric.median_ms, metric.relative);
+        metrics.push_back(metric);
+    };
+
+    const std::string dense_sphere_text = scenes::GenerateDenseSphereObj();
+
+    add_metric("parse/sphere_80k", 0.3, [&]() {
+        return MeasureParse(dense_sphere_text);
+    });
+
+    for (const scenes::Scene &scene : scenes::CreateScenes(true)) {
+        add_metric((std::string("render/") + scene.name).c_str(), 0.3, [&]() {
+            return MeasureRender(options, scene);
+        });
+    }
+
+    return metrics;
+}
+
+// Prints the metrics side by side with the baseline and returns whether none of them regressed.
+static bool Compare(const std::vector<Metric> &baseline, const std::vector<Metric> &metrics) {
+    bool passed = true;
+
+    std::printf("\n%-32s %12s %12s %9s %9s\n", "Metric (relative)", "Baseline", "Current", "Change", "Limit");
+
+    for (const Metric &metric : metrics) {
+        const auto it = std::find_if(baseline.begin(), baseline.end(), [&](const Metric &baseline_metric) {
+            return baseline_metric.name == metric.name;
+        });
+
+        if (it == baseline.end()) {
+            std::printf("%-32s %12s %12.4f %9s %9s  new, not in the baseline\n", metric.name.c_str(), "-",
+                        metric.relative, "-", "-");
+            continue;
+        }
+
+        const double change = metric.relative / it->relative - 1;
+
+        const char *status = "ok";
+        if (change > it->tolerance) {
+            status = "REGRESSION";
+            passed = false;
+        } else if (change < -it->tolerance) {
+            status = "faster, consider updating the baseline";
+        }
+
+        std::printf("%-32s %12.4f %12.4f %+8.1f%% %+8.1f%%  %s\n", metric.name.c_str(), it->relative,
+                    metric.relative, change * 100, it->tolerance * 100, status);
+    }
+
+    for (const Metric &baseline_metric : baseline) {
+        const bool measured = std::any_of(metrics.begin(), metrics.end(), [&](const Metric &metric) {
+            return metric.name == baseline_metric.name;
+        });
+
+        if (!measured) {
+            std::printf("%-32s %12.4f %12s %9s %9s  MISSING, not measured anymore\n",
+                        baseline_metric.name.c_str(), baseline_metric.relative, "-", "-", "-");
+            passed = false;
+        }
+    }
+
+    return passed;
+}
+
+int main(int argc, char **argv) {
+    Options options;
+    if (!ParseOptions(argc, argv, &options)) {
+        PrintUsage(argv[0]);
+        return 1;
+    }
+
+    std::vector<Metric> baseline;
+    const bool has_baseline = ReadBaseline(options.baseline_path, &baseline);
+
+    if (!has_baseline && !options.update) {
+        std::printf("Unable to read the baseline %s.\n", options.baseline_path.c_str());
+        return 1;
+    }
+
+    std::vector<Metric> metrics = RunScenarios(options);
+    if (metrics.empty())
+        return 1;
+
+    if (!options.output_path.empty() && !WriteBaseline(options.output_path, metrics)) {
+        std::printf("Unable to write %s.\n", options.output_path.c_str());
+        return 1;
+    }
+
+    if (options.update) {
+        for (Metric &metric : metrics) {
+            for (const Metric &baseline_metric : baseline) {
+                if (baseline_metric.name == metric.name)
+                    metric.tolerance = baseline_metric.tolerance;
+            }
+        }
+
+        if (!WriteBaseline(options.baseline_path, metrics)) {
+            std::printf("Unable to write %s.\n", options.baseline_path.c_str());
+            return 1;
+        }
+
+        std::printf("Baseline %s updated.\n", options.baseline_path.c_str());
+        return 0;
+    }
+
+    if (!Compare(baseline, metrics)) {
+        std::printf("\nPerformance regressed.\n");
+        return 1;
+    }
+
+    std::printf("\nNo regressions.\n");
+    return 0;
+}